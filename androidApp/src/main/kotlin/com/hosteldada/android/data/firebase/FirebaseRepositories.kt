@@ -5,8 +5,22 @@ import com.google.firebase.auth.GoogleAuthProvider
 import com.google.firebase.database.FirebaseDatabase
 import com.google.firebase.firestore.FirebaseFirestore
 import com.hosteldada.android.di.*
+import com.hosteldada.core.domain.algorithm.SnackSearchFilter
+import com.hosteldada.core.domain.algorithm.SnackTrigramIndex
+import com.hosteldada.core.domain.model.ScoringProfile
+import com.hosteldada.core.domain.model.SnackCategory
+import com.hosteldada.core.domain.model.Snack as SearchableSnack
+import com.hosteldada.core.domain.repository.ScoringProfileRepository
+import com.hosteldada.core.common.result.Result as DomainResult
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.asExecutor
+import kotlinx.coroutines.channels.awaitClose
 import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.callbackFlow
 import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.tasks.await
 import kotlinx.coroutines.withContext
 
@@ -198,6 +212,13 @@ class FirebaseSnackCartRepositoryImpl(
     private val ordersCollection = firestore.collection("orders")
     private val cartRef = realtimeDb.getReference("carts")
     
+    // Substring index over the latest catalog, rebuilt by getSnacks() and by
+    // the catalog sync search starts on first use
+    private val searchIndex = SnackTrigramIndex()
+    @Volatile private var indexedSnacks: Map<String, Snack> = emptyMap()
+    private val syncScope = CoroutineScope(SupervisorJob() + dispatchers.io)
+    @Volatile private var catalogSync: Job? = null
+    
     /**
      * Get all available snacks
      * Uses Firestore for persistence
@@ -212,6 +233,7 @@ class FirebaseSnackCartRepositoryImpl(
             val snacks = snapshot.documents.mapNotNull { 
                 it.toObject(Snack::class.java)?.copy(id = it.id)
             }
+            indexCatalog(snacks)
             Result.success(snacks)
         } catch (e: Exception) {
             Result.failure(e)
@@ -219,25 +241,91 @@ class FirebaseSnackCartRepositoryImpl(
     }
     
     /**
-     * Search snacks by name
-     * This could use the Trie data structure for efficient prefix search
+     * Search snacks by substring of name or category
+     * Firebase doesn't support full-text search natively, so the catalog is
+     * fetched once and queried through the shared trigram index
      */
     suspend fun searchSnacks(query: String): Result<List<Snack>> = 
         withContext(dispatchers.io) {
             try {
-                // Firebase doesn't support full-text search natively
-                // In production, use Algolia/Elasticsearch or client-side filtering
-                val allSnacks = getSnacks().getOrThrow()
-                val filtered = allSnacks.filter { snack ->
-                    snack.name.contains(query, ignoreCase = true) ||
-                    snack.category.contains(query, ignoreCase = true)
-                }
-                Result.success(filtered)
+                listenForCatalogChanges()
+                if (searchIndex.getSize() == 0) getSnacks().getOrThrow()
+                
+                // getSnacks() already keeps only available snacks
+                val matches = searchIndex
+                    .search(query, SnackSearchFilter(includeUnavailable = true))
+                    .mapNotNull { indexedSnacks[it.id] }
+                Result.success(matches)
             } catch (e: Exception) {
                 Result.failure(e)
             }
         }
     
+    /**
+     * Observe the available catalog in real time.
+     * The snapshot listener is removed when the collector is cancelled.
+     */
+    fun observeSnacks(): Flow<List<Snack>> = callbackFlow {
+        val registration = snacksCollection
+            .whereEqualTo("available", true)
+            .addSnapshotListener(dispatchers.io.asExecutor()) { snapshot, error ->
+                if (error != null) {
+                    close(error)
+                    return@addSnapshotListener
+                }
+                snapshot ?: return@addSnapshotListener
+                trySend(snapshot.documents.mapNotNull {
+                    it.toObject(Snack::class.java)?.copy(id = it.id)
+                })
+            }
+        awaitClose { registration.remove() }
+    }
+    
+    /**
+     * Rebuild the index whenever the available catalog changes, so search
+     * never serves a stale snapshot. Started once; rebuilds run off the
+     * main thread until [close].
+     */
+    private fun listenForCatalogChanges() {
+        if (catalogSync != null) return
+        synchronized(this) {
+            if (catalogSync != null) return
+            catalogSync = syncScope.launch {
+                observeSnacks().collect { indexCatalog(it) }
+            }
+        }
+    }
+    
+    /**
+     * Stop the catalog sync, removing its Firestore listener.
+     */
+    fun close() {
+        synchronized(this) {
+            catalogSync?.cancel()
+            catalogSync = null
+        }
+    }
+    
+    private fun indexCatalog(snacks: List<Snack>) {
+        indexedSnacks = snacks.associateBy { it.id }
+        searchIndex.rebuild(snacks.map { it.toSearchable() })
+    }
+    
+    // Free-text categories that match no SnackCategory stay searchable as a tag
+    private fun Snack.toSearchable(): SearchableSnack {
+        val known = SnackCategory.values().firstOrNull {
+            it.name.equals(category.trim().replace(' ', '_'), ignoreCase = true)
+        }
+        return SearchableSnack(
+            id = id,
+            name = name,
+            category = known ?: SnackCategory.OTHER,
+            isAvailable = available,
+            stockQuantity = stock,
+            tags = if (known == null && category.isNotBlank()) listOf(category) else emptyList()
+        )
+    }
+    
     /**
      * Get user's cart
      * Uses Realtime Database for real-time sync
@@ -514,6 +602,51 @@ class FirebaseRoomieRepositoryImpl(
     }
 }
 
+// ============================================================================
+// SCORING PROFILE REPOSITORY IMPLEMENTATION
+// ============================================================================
+
+/**
+ * Admin scoring profiles in Firestore, one document per semester.
+ * Implements the shared domain interface, so it reports through the
+ * domain Result rather than kotlin.Result.
+ */
+class FirebaseScoringProfileRepositoryImpl(
+    private val firestore: FirebaseFirestore,
+    private val dispatchers: DispatcherProvider
+) : ScoringProfileRepository {
+    
+    private val profilesCollection = firestore.collection("scoring_profiles")
+    
+    /**
+     * Profile saved for [semester], or null when the admin never saved one
+     */
+    override suspend fun getProfile(semester: String): DomainResult<ScoringProfile?> =
+        withContext(dispatchers.io) {
+            try {
+                val snapshot = profilesCollection.document(semester).get().await()
+                DomainResult.Success(snapshot.toObject(ScoringProfile::class.java))
+            } catch (e: Exception) {
+                DomainResult.Error(e)
+            }
+        }
+    
+    /**
+     * Replace the semester's profile; the document id is the semester
+     */
+    override suspend fun saveProfile(profile: ScoringProfile): DomainResult<Unit> =
+        withContext(dispatchers.io) {
+            try {
+                profilesCollection.document(profile.semester)
+                    .set(profile.copy(id = profile.semester))
+                    .await()
+                DomainResult.Success(Unit)
+            } catch (e: Exception) {
+                DomainResult.Error(e)
+            }
+        }
+}
+
 // Roomie domain models
 data class RoomieProfile(
     val userId: String = "",
@@ -2,12 +2,14 @@ package com.hosteldada.android
 
 import org.koin.androidx.viewmodel.dsl.viewModel
 import org.koin.dsl.module
+import org.koin.dsl.onClose
 import com.google.firebase.auth.FirebaseAuth
 import com.google.firebase.database.FirebaseDatabase
 import com.google.firebase.firestore.FirebaseFirestore
 import com.google.firebase.storage.FirebaseStorage
 import com.hosteldada.android.data.firebase.*
 import com.hosteldada.android.presentation.viewmodel.*
+import com.hosteldada.core.domain.repository.ScoringProfileRepository
 
 /**
  * Koin Dependency Injection Modules for Android App
@@ -58,7 +60,7 @@ val repositoryModule = module {
             realtimeDb = get(),
             dispatchers = get()
         ) 
-    }
+    } onClose { (it as? FirebaseSnackCartRepositoryImpl)?.close() }
     
     // Roomie Repository
     single<RoomieRepository> { 
@@ -68,6 +70,14 @@ val repositoryModule = module {
             dispatchers = get()
         ) 
     }
+    
+    // Scoring profiles for roommate matching (admin-tuned, per semester)
+    single<ScoringProfileRepository> { 
+        FirebaseScoringProfileRepositoryImpl(
+            firestore = get(),
+            dispatchers = get()
+        ) 
+    }
 }
 
 // Use Case module
@@ -11,6 +11,7 @@ object Versions {
     const val coroutines = "1.7.3"
     const val serialization = "1.6.2"
     const val datetime = "0.5.0"
+    const val atomicfu = "0.23.1"
     
     // Compose
     const val compose = "1.5.11"
@@ -48,6 +49,7 @@ object Deps {
         const val coroutinesAndroid = "org.jetbrains.kotlinx:kotlinx-coroutines-android:${Versions.coroutines}"
         const val serializationJson = "org.jetbrains.kotlinx:kotlinx-serialization-json:${Versions.serialization}"
         const val datetime = "org.jetbrains.kotlinx:kotlinx-datetime:${Versions.datetime}"
+        const val atomicfu = "org.jetbrains.kotlinx:atomicfu:${Versions.atomicfu}"
     }
     
     object Android {
@@ -11,3 +11,5 @@ actual class DispatcherProviderImpl actual constructor() : DispatcherProvider {
     actual override val io: CoroutineDispatcher = Dispatchers.IO
     actual override val default: CoroutineDispatcher = Dispatchers.Default
 }
+
+actual fun availableProcessors(): Int = Runtime.getRuntime().availableProcessors()
@@ -24,3 +24,9 @@ expect class DispatcherProviderImpl() : DispatcherProvider {
     override val io: CoroutineDispatcher
     override val default: CoroutineDispatcher
 }
+
+/**
+ * Processors available to the app; CPU-bound work split across
+ * [DispatcherProvider.default] gains nothing from more workers.
+ */
+expect fun availableProcessors(): Int
@@ -0,0 +1,214 @@
+package com.hosteldada.core.common.telemetry
+
+import kotlinx.atomicfu.AtomicLongArray
+import kotlinx.atomicfu.atomic
+import kotlinx.atomicfu.atomicArrayOfNulls
+import kotlin.math.ceil
+
+/**
+ * ============================================
+ * SEARCH TELEMETRY
+ * ============================================
+ * 
+ * Lock-free recorder for search calls, cheap enough for every keystroke.
+ * 
+ * - The last [capacity] events live in a ring buffer: a writer claims a
+ *   slot with one atomic increment and publishes an immutable event into
+ *   it, overwriting the oldest; writers never wait on each other or readers
+ * - Every latency also lands in a cumulative log-linear histogram (8 linear
+ *   sub-buckets per power of two, <= 12.5% error) of atomic counters
+ * - [report] aggregates percentiles and the most frequent zero-result
+ *   queries on the reader's thread; [exportCsv] dumps the ring
+ * 
+ * Time Complexity:
+ * - record: O(1), one allocation for the event
+ * - report: O(capacity + B) where B is the histogram bucket count
+ */
+class SearchTelemetry(capacity: Int = DEFAULT_CAPACITY) {
+    
+    private val capacity: Int = capacity.coerceAtLeast(1).takeHighestOneBit().let {
+        if (it < capacity) it shl 1 else it
+    }
+    private val mask = this.capacity - 1L
+    
+    private val slots = atomicArrayOfNulls<SearchEvent>(this.capacity)
+    private val sequence = atomic(0L)
+    private val histogram = AtomicLongArray(BUCKET_COUNT)
+    
+    /**
+     * Record one search. [latencyNanos] should come from a monotonic clock.
+     * Time: O(1)
+     */
+    fun record(
+        query: String,
+        normalized: String,
+        resultCount: Int,
+        indexVersion: Int,
+        latencyNanos: Long
+    ) {
+        val event = SearchEvent(query, normalized, resultCount, indexVersion, latencyNanos)
+        val claimed = sequence.getAndIncrement()
+        slots[(claimed and mask).toInt()].value = event
+        histogram[bucketOf(latencyNanos)].incrementAndGet()
+    }
+    
+    /**
+     * Events still in the ring, oldest first.
+     * Time: O(capacity)
+     */
+    fun recentEvents(): List<SearchEvent> {
+        val end = sequence.value
+        val start = maxOf(0L, end - capacity)
+        val events = ArrayList<SearchEvent>((end - start).toInt())
+        for (claimed in start until end) {
+            // Best effort under concurrent writes: a slot being rewritten shows either event
+            val event = slots[(claimed and mask).toInt()].value ?: continue
+            events.add(event)
+        }
+        return events
+    }
+    
+    /**
+     * Latency percentiles over every recorded search and the most frequent
+     * zero-result queries (by normalized form) among recent ones.
+     * Time: O(capacity + B)
+     */
+    fun report(zeroResultLimit: Int = DEFAULT_ZERO_RESULT_LIMIT): SearchTelemetryReport {
+        val counts = LongArray(BUCKET_COUNT) { histogram[it].value }
+        val total = counts.sum()
+        
+        val recent = recentEvents()
+        val zeroResults = recent.filter { it.resultCount == 0 }
+        val zeroResultQueries = zeroResults
+            .groupingBy { it.normalized.ifEmpty { it.query } }
+            .eachCount()
+            .entries
+            .sortedWith(compareByDescending<Map.Entry<String, Int>> { it.value }.thenBy { it.key })
+            .take(zeroResultLimit)
+            .map { QueryCount(it.key, it.value) }
+        
+        return SearchTelemetryReport(
+            totalSearches = total,
+            recentSearches = recent.size,
+            recentZeroResultSearches = zeroResults.size,
+            latency = LatencySummary(
+                p50Nanos = percentile(counts, total, 0.50),
+                p90Nanos = percentile(counts, total, 0.90),
+                p99Nanos = percentile(counts, total, 0.99),
+                maxNanos = percentile(counts, total, 1.0)
+            ),
+            histogram = counts.indices
+                .filter { counts[it] > 0 }
+                .map { LatencyBucket(upperBoundOf(it), counts[it]) },
+            zeroResultQueries = zeroResultQueries
+        )
+    }
+    
+    /**
+     * Recent events as CSV with a header row, oldest first.
+     * Time: O(capacity)
+     */
+    fun exportCsv(): String = buildString {
+        append("query,normalized,results,index_version,latency_ns\n")
+        recentEvents().forEach { event ->
+            append(csvField(event.query)).append(',')
+            append(csvField(event.normalized)).append(',')
+            append(event.resultCount).append(',')
+            append(event.indexVersion).append(',')
+            append(event.latencyNanos).append('\n')
+        }
+    }
+    
+    /**
+     * Drop recorded events and histogram counts. Concurrent records may survive.
+     */
+    fun reset() {
+        for (i in 0 until capacity) slots[i].value = null
+        for (i in 0 until BUCKET_COUNT) histogram[i].value = 0L
+    }
+    
+    private fun csvField(value: String): String =
+        if (value.any { it == ',' || it == '"' || it == '\n' }) "\"" + value.replace("\"", "\"\"") + "\"" else value
+    
+    companion object {
+        const val DEFAULT_CAPACITY = 1024
+        const val DEFAULT_ZERO_RESULT_LIMIT = 10
+        
+        private const val SUB_BITS = 3
+        private const val SUB_BUCKETS = 1 shl SUB_BITS
+        
+        // Exponents SUB_BITS..62, plus the exact buckets below SUB_BUCKETS
+        private const val BUCKET_COUNT = (63 - SUB_BITS + 1) * SUB_BUCKETS
+        
+        private fun bucketOf(nanos: Long): Int {
+            if (nanos < SUB_BUCKETS) return maxOf(0L, nanos).toInt()
+            val exponent = 63 - nanos.countLeadingZeroBits()
+            val sub = ((nanos ushr (exponent - SUB_BITS)) and (SUB_BUCKETS - 1L)).toInt()
+            return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub
+        }
+        
+        private fun upperBoundOf(bucket: Int): Long {
+            if (bucket < SUB_BUCKETS) return bucket.toLong()
+            val exponent = bucket / SUB_BUCKETS + SUB_BITS - 1
+            val sub = bucket % SUB_BUCKETS
+            val width = 1L shl (exponent - SUB_BITS)
+            return (SUB_BUCKETS + sub) * width + width - 1
+        }
+        
+        // Upper bound of the bucket holding the rank-th latency
+        private fun percentile(counts: LongArray, total: Long, fraction: Double): Long {
+            if (total == 0L) return 0L
+            val rank = maxOf(1L, ceil(total * fraction).toLong())
+            var seen = 0L
+            for (bucket in counts.indices) {
+                seen += counts[bucket]
+                if (seen >= rank) return upperBoundOf(bucket)
+            }
+            return upperBoundOf(counts.size - 1)
+        }
+    }
+}
+
+/**
+ * One recorded search.
+ */
+data class SearchEvent(
+    val query: String,
+    val normalized: String,
+    val resultCount: Int,
+    val indexVersion: Int,
+    val latencyNanos: Long
+)
+
+data class LatencySummary(
+    val p50Nanos: Long = 0,
+    val p90Nanos: Long = 0,
+    val p99Nanos: Long = 0,
+    val maxNanos: Long = 0
+)
+
+/**
+ * Histogram bucket: [count] searches took at most [upperNanos].
+ */
+data class LatencyBucket(
+    val upperNanos: Long,
+    val count: Long
+)
+
+data class QueryCount(
+    val query: String,
+    val count: Int
+)
+
+data class SearchTelemetryReport(
+    val totalSearches: Long = 0,
+    val recentSearches: Int = 0,
+    val recentZeroResultSearches: Int = 0,
+    val latency: LatencySummary = LatencySummary(),
+    val histogram: List<LatencyBucket> = emptyList(),
+    val zeroResultQueries: List<QueryCount> = emptyList()
+) {
+    companion object {
+        val EMPTY = SearchTelemetryReport()
+    }
+}
@@ -2,6 +2,7 @@ package com.hosteldada.core.common
 
 import kotlinx.coroutines.CoroutineDispatcher
 import kotlinx.coroutines.Dispatchers
+import platform.Foundation.NSProcessInfo
 
 /**
  * iOS implementation of DispatcherProvider
@@ -12,3 +13,5 @@ actual class DispatcherProviderImpl actual constructor() : DispatcherProvider {
     actual override val io: CoroutineDispatcher = Dispatchers.Default  // No IO on iOS
     actual override val default: CoroutineDispatcher = Dispatchers.Default
 }
+
+actual fun availableProcessors(): Int = NSProcessInfo.processInfo.activeProcessorCount.toInt()
@@ -0,0 +1,51 @@
+package com.hosteldada.core.data.local
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.File
+
+/**
+ * Android implementation of SnackSearchIndexLocalDataSource.
+ * Stores one index file per sync timestamp in [directory] (e.g. filesDir)
+ * and reads it back in one sequential read.
+ */
+class FileSnackSearchIndexDataSource(
+    private val directory: File
+) : SnackSearchIndexLocalDataSource {
+    
+    override suspend fun readIndex(syncTimestamp: Long): ByteArray? = withContext(Dispatchers.IO) {
+        val file = indexFile(syncTimestamp)
+        if (!file.isFile) return@withContext null
+        
+        file.readBytes()
+    }
+    
+    override suspend fun writeIndex(syncTimestamp: Long, bytes: ByteArray) = withContext(Dispatchers.IO) {
+        directory.mkdirs()
+        
+        // Write then rename, so a crash never leaves a torn index behind
+        val temp = File(directory, "$FILE_PREFIX$syncTimestamp.tmp")
+        temp.writeBytes(bytes)
+        val target = indexFile(syncTimestamp)
+        if (!temp.renameTo(target)) {
+            temp.delete()
+            return@withContext
+        }
+        
+        indexFiles().filter { it != target }.forEach { it.delete() }
+    }
+    
+    override suspend fun deleteIndex() = withContext(Dispatchers.IO) {
+        indexFiles().forEach { it.delete() }
+    }
+    
+    private fun indexFile(syncTimestamp: Long) = File(directory, "$FILE_PREFIX$syncTimestamp$FILE_SUFFIX")
+    
+    private fun indexFiles(): List<File> =
+        directory.listFiles { file -> file.name.startsWith(FILE_PREFIX) }?.toList() ?: emptyList()
+    
+    private companion object {
+        const val FILE_PREFIX = "snack-search-"
+        const val FILE_SUFFIX = ".idx"
+    }
+}
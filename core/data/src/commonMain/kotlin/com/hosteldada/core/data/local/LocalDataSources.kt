@@ -33,6 +33,17 @@ interface SnackLocalDataSource {
     suspend fun setLastSyncTimestamp(timestamp: Long)
 }
 
+/**
+ * File-backed store for the serialized snack search index.
+ * Each index is keyed by the snack sync timestamp it was built after,
+ * so an index from an older sync is never read back.
+ */
+interface SnackSearchIndexLocalDataSource {
+    suspend fun readIndex(syncTimestamp: Long): ByteArray?
+    suspend fun writeIndex(syncTimestamp: Long, bytes: ByteArray)
+    suspend fun deleteIndex()
+}
+
 /**
  * SQLDelight Local Data Source interface for Cart
  */
@@ -139,7 +139,8 @@ class ProfileRepositoryImpl(
  */
 class SnackRepositoryImpl(
     private val remoteDataSource: SnackRemoteDataSource,
-    private val localDataSource: SnackLocalDataSource
+    private val localDataSource: SnackLocalDataSource,
+    private val searchIndexDataSource: SnackSearchIndexLocalDataSource? = null
 ) : SnackRepository {
     
     override suspend fun getAllSnacks(cachePolicy: CachePolicy): Result<List<Snack>> {
@@ -201,6 +202,18 @@ class SnackRepositoryImpl(
         return remoteDataSource.searchSnacks(query)
     }
     
+    override suspend fun loadSearchIndex(): ByteArray? {
+        val store = searchIndexDataSource ?: return null
+        val syncTimestamp = localDataSource.getLastSyncTimestamp() ?: return null
+        return store.readIndex(syncTimestamp)
+    }
+    
+    override suspend fun saveSearchIndex(bytes: ByteArray) {
+        val store = searchIndexDataSource ?: return
+        val syncTimestamp = localDataSource.getLastSyncTimestamp() ?: return
+        store.writeIndex(syncTimestamp, bytes)
+    }
+    
     override suspend fun createSnack(snack: Snack): Result<Snack> {
         return when (val result = remoteDataSource.createSnack(snack)) {
             is Result.Success -> {
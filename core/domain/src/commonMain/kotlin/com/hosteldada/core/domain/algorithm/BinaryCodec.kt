@@ -0,0 +1,145 @@
+package com.hosteldada.core.domain.algorithm
+
+/**
+ * ============================================
+ * BINARY CODEC
+ * ============================================
+ * 
+ * Minimal big-endian encoder / decoder and CRC-32 used by persisted
+ * search indexes. Common code only, no platform I/O.
+ */
+
+/**
+ * Growable byte buffer.
+ * Time: O(1) amortized per write
+ */
+internal class ByteSink(initialCapacity: Int = 1024) {
+    
+    private var buffer = ByteArray(initialCapacity)
+    
+    var size = 0
+        private set
+    
+    fun writeByte(value: Int) {
+        ensure(1)
+        buffer[size++] = value.toByte()
+    }
+    
+    fun writeBoolean(value: Boolean) = writeByte(if (value) 1 else 0)
+    
+    fun writeInt(value: Int) {
+        ensure(4)
+        buffer[size++] = (value ushr 24).toByte()
+        buffer[size++] = (value ushr 16).toByte()
+        buffer[size++] = (value ushr 8).toByte()
+        buffer[size++] = value.toByte()
+    }
+    
+    fun writeLong(value: Long) {
+        writeInt((value ushr 32).toInt())
+        writeInt(value.toInt())
+    }
+    
+    // UTF-8, length-prefixed
+    fun writeString(value: String) {
+        val bytes = value.encodeToByteArray()
+        writeInt(bytes.size)
+        ensure(bytes.size)
+        bytes.copyInto(buffer, size)
+        size += bytes.size
+    }
+    
+    // Count-prefixed
+    fun writeInts(values: IntArray, from: Int = 0, to: Int = values.size) {
+        writeInt(to - from)
+        ensure((to - from) * 4)
+        for (i in from until to) writeInt(values[i])
+    }
+    
+    fun toByteArray(): ByteArray = buffer.copyOf(size)
+    
+    private fun ensure(extra: Int) {
+        if (size + extra > buffer.size) {
+            buffer = buffer.copyOf(maxOf(buffer.size * 2, size + extra))
+        }
+    }
+}
+
+/**
+ * Reader over `bytes[0 until end]`. Reading past [end] or a negative length
+ * throws, so truncated input fails instead of decoding garbage.
+ */
+internal class ByteSource(private val bytes: ByteArray, private val end: Int = bytes.size) {
+    
+    var position = 0
+        private set
+    
+    fun readByte(): Int {
+        require(end - position >= 1) { "Unexpected end of input" }
+        return bytes[position++].toInt() and 0xFF
+    }
+    
+    fun readBoolean(): Boolean = readByte() != 0
+    
+    fun readInt(): Int {
+        require(end - position >= 4) { "Unexpected end of input" }
+        val value = (bytes[position].toInt() and 0xFF shl 24) or
+            (bytes[position + 1].toInt() and 0xFF shl 16) or
+            (bytes[position + 2].toInt() and 0xFF shl 8) or
+            (bytes[position + 3].toInt() and 0xFF)
+        position += 4
+        return value
+    }
+    
+    fun readLong(): Long {
+        val high = readInt().toLong()
+        val low = readInt().toLong() and 0xFFFFFFFFL
+        return (high shl 32) or low
+    }
+    
+    fun readString(): String {
+        val length = readLength(1)
+        val value = bytes.decodeToString(position, position + length)
+        position += length
+        return value
+    }
+    
+    fun readInts(): IntArray {
+        val count = readLength(4)
+        return IntArray(count) { readInt() }
+    }
+    
+    /**
+     * Read a count and check that [unitSize] * count bytes remain.
+     */
+    fun readLength(unitSize: Int): Int {
+        val count = readInt()
+        require(count >= 0 && count.toLong() * unitSize <= end - position) { "Invalid length $count" }
+        return count
+    }
+}
+
+/**
+ * CRC-32 (IEEE 802.3), table-driven.
+ */
+internal object Crc32 {
+    
+    private val TABLE = IntArray(256) { n ->
+        var c = n
+        repeat(8) {
+            c = if (c and 1 != 0) (c ushr 1) xor 0xEDB88320.toInt() else c ushr 1
+        }
+        c
+    }
+    
+    /**
+     * Time: O(to - from)
+     */
+    fun compute(bytes: ByteArray, from: Int = 0, to: Int = bytes.size): Int {
+        var crc = -1
+        for (i in from until to) {
+            crc = TABLE[(crc xor bytes[i].toInt()) and 0xFF] xor (crc ushr 8)
+        }
+        return crc.inv()
+    }
+}
@@ -0,0 +1,226 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.common.availableProcessors
+import com.hosteldada.core.domain.model.CompatibilityScore
+import com.hosteldada.core.domain.model.RoommateSurvey
+import kotlinx.atomicfu.atomic
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.ensureActive
+import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.launch
+
+/**
+ * ============================================
+ * COMPATIBILITY BATCH ENGINE
+ * ============================================
+ * 
+ * Scores every pair of a semester's surveys in parallel and streams the
+ * edges to a persistence stage, so writes overlap with scoring instead of
+ * following each pair.
+ * 
+ * - Surveys are encoded once into a [SurveyFeatureMatrix]
+ * - With [generatePartitioned], only pairs inside a partition are scored;
+ *   the tiles of all partitions share one work queue, so partitions run
+ *   in parallel and small ones fill in around large ones
+ * - Pairs ruled out by a deal-breaker are skipped with one mask AND and
+ *   never scored or persisted
+ * - The upper triangle of the pair matrix is cut into [tileSize] x
+ *   [tileSize] tiles; two row blocks of a tile fit in L1, so a tile is
+ *   scored without cache misses on the feature columns
+ * - [parallelism] workers on [dispatcher], one per processor by default,
+ *   claim tiles from an atomic counter, so uneven tiles (diagonal ones
+ *   are half full) balance out
+ * - Each finished tile is sent as one batch through a bounded channel;
+ *   when persistence falls behind, workers suspend instead of buffering
+ *   the whole O(n²) result
+ * - Cancelling the caller cancels workers between tiles and stops the
+ *   persistence stage; a failing write cancels the workers
+ * 
+ * Time Complexity:
+ * - O(n²) scoring, or O(Σ nᵢ²) over partitions, split over [parallelism]
+ *   workers
+ * - Space: O(n) features plus O(parallelism * tileSize²) in-flight edges
+ */
+class CompatibilityBatchEngine(
+    private val dispatcher: CoroutineDispatcher,
+    private val parallelism: Int = DEFAULT_PARALLELISM,
+    private val tileSize: Int = DEFAULT_TILE_SIZE
+) {
+    
+    init {
+        require(parallelism > 0) { "parallelism must be positive" }
+        require(tileSize > 0) { "tileSize must be positive" }
+    }
+    
+    /**
+     * Score all pairs of [surveys] under [plan] and hand them to [persist]
+     * one tile at a time, in the caller's context. Edges are stamped with
+     * [profileVersion], the `updatedAt` of the profile [plan] was compiled
+     * from. [onProgress] runs after each persisted tile. Returns the number of pairs persisted, which
+     * excludes pairs ruled out by deal-breakers.
+     * Time: O(n² / parallelism) scoring, plus persistence
+     */
+    suspend fun generate(
+        surveys: List<RoommateSurvey>,
+        plan: ScoringPlan = ScoringPlan.DEFAULT,
+        profileVersion: Long = 0,
+        onProgress: (CompatibilityProgress) -> Unit = {},
+        persist: suspend (List<CompatibilityScore>) -> Unit
+    ): Long = generatePartitioned(listOf(surveys), plan, profileVersion, onProgress, persist)
+    
+    /**
+     * Like [generate], but only pairs within the same partition are scored
+     * and counted towards progress.
+     * Time: O(Σ nᵢ² / parallelism) scoring, plus persistence
+     */
+    suspend fun generatePartitioned(
+        partitions: List<List<RoommateSurvey>>,
+        plan: ScoringPlan = ScoringPlan.DEFAULT,
+        profileVersion: Long = 0,
+        onProgress: (CompatibilityProgress) -> Unit = {},
+        persist: suspend (List<CompatibilityScore>) -> Unit
+    ): Long = coroutineScope {
+        val totalPairs = partitions.sumOf { it.size.toLong() * (it.size - 1) / 2 }
+        if (totalPairs == 0L) return@coroutineScope 0L
+        
+        // Partitions laid out back to back as row ranges
+        val surveys = partitions.flatten()
+        val features = SurveyFeatureMatrix(surveys.size, plan)
+        surveys.forEach { features.add(it) }
+        
+        val tiles = partitionTiles(partitions)
+        val tileCount = tiles.size / 3
+        val nextTile = atomic(0)
+        val calculatedAt = System.currentTimeMillis()
+        val batches = Channel<TileBatch>(capacity = parallelism)
+        
+        val workers = List(minOf(parallelism, tileCount)) {
+            launch(dispatcher) {
+                val categories = IntArray(SurveyFeatureMatrix.CATEGORY_COUNT)
+                while (true) {
+                    val tile = nextTile.getAndIncrement()
+                    if (tile >= tileCount) break
+                    ensureActive()
+                    batches.send(
+                        scoreTile(
+                            surveys, features, tiles[3 * tile], tiles[3 * tile + 1], tiles[3 * tile + 2],
+                            categories, profileVersion, calculatedAt
+                        )
+                    )
+                }
+            }
+        }
+        launch {
+            workers.joinAll()
+            batches.close()
+        }
+        
+        // Persistence stage
+        var saved = 0L
+        var processed = 0L
+        for (batch in batches) {
+            if (batch.scores.isNotEmpty()) persist(batch.scores)
+            saved += batch.scores.size
+            processed += batch.pairs
+            onProgress(CompatibilityProgress(saved, processed, totalPairs))
+        }
+        saved
+    }
+    
+    /**
+     * Edges of the compatible pairs in the tile whose row and column blocks
+     * start at [rowStart] and [columnStart], in a partition ending at
+     * [end]; on the diagonal only pairs above it.
+     * Time: O(tileSize²)
+     */
+    private fun scoreTile(
+        surveys: List<RoommateSurvey>,
+        features: SurveyFeatureMatrix,
+        rowStart: Int,
+        columnStart: Int,
+        end: Int,
+        categories: IntArray,
+        profileVersion: Long,
+        calculatedAt: Long
+    ): TileBatch {
+        val rowEnd = minOf(end, rowStart + tileSize)
+        val columnEnd = minOf(end, columnStart + tileSize)
+        val batch = ArrayList<CompatibilityScore>(tileSize * tileSize)
+        var pairs = 0
+        
+        for (i in rowStart until rowEnd) {
+            val from = if (rowStart == columnStart) i + 1 else columnStart
+            for (j in from until columnEnd) {
+                pairs++
+                if (!features.compatible(i, j)) continue
+                val overall = features.score(i, j, categories)
+                batch.add(
+                    CompatibilityGraph.buildScore(
+                        surveys[i].studentId, surveys[j].studentId, overall, categories,
+                        features.warnings(i, j), surveys[i].updatedAt, surveys[j].updatedAt,
+                        profileVersion, calculatedAt
+                    )
+                )
+            }
+        }
+        return TileBatch(batch, pairs)
+    }
+    
+    /**
+     * (rowStart, columnStart, partitionEnd) of every upper-triangle tile of
+     * every partition, flattened, with partitions laid out back to back.
+     * Time: O(Σ (nᵢ / tileSize)²)
+     */
+    private fun partitionTiles(partitions: List<List<RoommateSurvey>>): IntArray {
+        var count = 0
+        for (partition in partitions) {
+            if (partition.size < 2) continue
+            val blocks = (partition.size + tileSize - 1) / tileSize
+            count += blocks * (blocks + 1) / 2
+        }
+        
+        val tiles = IntArray(3 * count)
+        var at = 0
+        var start = 0
+        for (partition in partitions) {
+            val end = start + partition.size
+            if (partition.size >= 2) {
+                val blocks = (partition.size + tileSize - 1) / tileSize
+                for (row in 0 until blocks) {
+                    for (column in row until blocks) {
+                        tiles[at++] = start + row * tileSize
+                        tiles[at++] = start + column * tileSize
+                        tiles[at++] = end
+                    }
+                }
+            }
+            start = end
+        }
+        return tiles
+    }
+    
+    // Scores of one tile and how many pairs it covered, skipped ones included
+    private class TileBatch(val scores: List<CompatibilityScore>, val pairs: Int)
+    
+    companion object {
+        // Scoring is CPU-bound, so one worker per processor
+        val DEFAULT_PARALLELISM: Int = availableProcessors().coerceAtLeast(1)
+        
+        // Two 64-row blocks of feature columns are ~6 KB
+        const val DEFAULT_TILE_SIZE = 64
+    }
+}
+
+/**
+ * Pairs processed so far out of [totalPairs]; [savedPairs] of them were
+ * compatible and persisted.
+ */
+data class CompatibilityProgress(
+    val savedPairs: Long = 0,
+    val processedPairs: Long = 0,
+    val totalPairs: Long = 0
+) {
+    val fraction: Float get() = if (totalPairs == 0L) 0f else processedPairs.toFloat() / totalPairs
+}
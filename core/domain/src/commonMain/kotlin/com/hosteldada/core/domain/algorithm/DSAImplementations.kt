@@ -1,6 +1,9 @@
 package com.hosteldada.core.domain.algorithm
 
 import com.hosteldada.core.domain.model.*
+import kotlinx.atomicfu.atomic
+import kotlinx.atomicfu.locks.SynchronizedObject
+import kotlinx.atomicfu.locks.synchronized
 
 /**
  * ============================================
@@ -16,135 +19,2215 @@ import com.hosteldada.core.domain.model.*
 // ==========================================
 
 /**
- * Trie (Prefix Tree) for efficient snack search.
+ * Path-compressed (radix) Trie for efficient snack search.
+ * 
+ * Layout:
+ * - Each node owns a compressed edge label instead of a single char
+ * - Children live in a sorted CharArray / Array pair (binary search, no maps)
+ * - Snacks are referenced by Int ordinal into a catalog table, never by object
+ * - Postings are a contiguous, sorted IntArray range per node
+ * - Each node caches its best [topK] ordinals under the current ranking
+ * - Availability, vegetarian and in-stock flags are per-ordinal bitsets kept
+ *   outside the trie; flipping one never touches nodes or top lists
+ * - Phonetic keys of every indexed word map to ordinals in a bucketed
+ *   table maintained alongside the trie on each write
+ * 
+ * Concurrency:
+ * - Nodes and the catalog table are immutable and structurally shared
+ * - Writers path-copy what they change and publish a new [Snapshot]
+ *   through an atomic reference; writers are serialized by a lock
+ * - Readers take one snapshot per call, never block and never see a
+ *   partially applied update
  * 
  * Time Complexity:
- * - Insert: O(k) where k is word length
- * - Search: O(k + m) where m is number of results
- * - Space: O(n * k) where n is number of words
+ * - Insert: O(k + m + K) per word where k is word length, m is postings
+ * - Remove / Update: O(k + m) per affected word, empty nodes are pruned
+ * - Session top results: O(k log σ + K) from the cached top list, O(m log m) for the tail
+ * - Fuzzy search: O(V q) where V is trie chars visited before pruning
+ * - Phonetic search: one hash probe per term into packed sound keys
+ * - Multi-term search: O(t k + s log(l / s)) galloping intersection, smallest list first
+ * - Binary snapshot: O(n + w + P) to write or restore, no re-sorting or re-ranking
+ * - Suggestions: best-first over cached subtree weights, O(k + limit σ log limit)
+ * - Session keystroke: O(1) to advance, results narrowed from the previous query
+ * - Space: O(w) nodes where w is number of distinct indexed words
  * 
  * Use Case: Instant search suggestions as user types
  */
-class SnackSearchTrie {
+class SnackSearchTrie(
+    ranking: Comparator<Snack> = SnackRanking(),
+    private val topK: Int = DEFAULT_TOP_K
+) {
     
-    private class TrieNode {
-        val children = mutableMapOf<Char, TrieNode>()
-        val snacks = mutableListOf<Snack>()
-        var isEndOfWord = false
+    /**
+     * Immutable radix node. [label] is the edge text leading into this node,
+     * [keys] holds the first char of each child label in sorted order.
+     * Postings live in `postings[postingFrom until postingFrom + postingCount]`.
+     * Nodes are compared by identity only; nothing needs structural equality.
+     */
+    private class RadixNode(
+        val label: String,
+        val keys: CharArray = NO_KEYS,
+        val children: Array<RadixNode> = NO_CHILDREN,
+        val postings: IntArray = NO_POSTINGS,
+        val postingFrom: Int = 0,
+        val postingCount: Int = 0,
+        // Ordinals with an indexed word ending exactly at this node
+        val terminals: IntArray = NO_POSTINGS,
+        // Best-ranked ordinals of this subtree, at most topK, best first
+        val top: IntArray = NO_POSTINGS,
+        // Times this word was picked from search results
+        val queryCount: Int = 0,
+        // Completion weight of this word: query hits plus units sold, 0 if not a word
+        val weight: Int = 0
+    ) {
+        val isEndOfWord: Boolean get() = terminals.isNotEmpty()
+        
+        fun copy(
+            label: String = this.label,
+            keys: CharArray = this.keys,
+            children: Array<RadixNode> = this.children,
+            postings: IntArray = this.postings,
+            postingFrom: Int = this.postingFrom,
+            postingCount: Int = this.postingCount,
+            terminals: IntArray = this.terminals,
+            top: IntArray = this.top,
+            queryCount: Int = this.queryCount,
+            weight: Int = this.weight
+        ): RadixNode = RadixNode(
+            label, keys, children, postings, postingFrom, postingCount, terminals, top, queryCount, weight
+        )
+        
+        // Heaviest completion in this subtree; recomputed by every copy
+        val bestWeight: Int = children.fold(weight) { best, child -> maxOf(best, child.bestWeight) }
+        
+        fun childIndex(key: Char): Int {
+            var low = 0
+            var high = keys.size - 1
+            while (low <= high) {
+                val mid = (low + high) ushr 1
+                val cmp = keys[mid].compareTo(key)
+                when {
+                    cmp < 0 -> low = mid + 1
+                    cmp > 0 -> high = mid - 1
+                    else -> return mid
+                }
+            }
+            return -(low + 1)
+        }
+        
+        fun hasPosting(ordinal: Int): Boolean =
+            PostingLists.indexOf(postings, postingFrom, postingFrom + postingCount, ordinal) >= 0
+        
+        /**
+         * Copy with an ordinal added, keeping the range sorted and distinct.
+         * Time: O(m)
+         */
+        fun withPosting(ordinal: Int): RadixNode {
+            val end = postingFrom + postingCount
+            val position = PostingLists.indexOf(postings, postingFrom, end, ordinal)
+            if (position >= 0) return this
+            val at = -(position + 1)
+            
+            val grown = IntArray(postingCount + 1)
+            postings.copyInto(grown, 0, postingFrom, at)
+            grown[at - postingFrom] = ordinal
+            postings.copyInto(grown, at - postingFrom + 1, at, end)
+            return copy(postings = grown, postingFrom = 0, postingCount = postingCount + 1)
+        }
+        
+        /**
+         * Copy with an ordinal removed.
+         * Time: O(m)
+         */
+        fun withoutPosting(ordinal: Int): RadixNode {
+            val end = postingFrom + postingCount
+            val position = PostingLists.indexOf(postings, postingFrom, end, ordinal)
+            if (position < 0) return this
+            
+            val shrunk = IntArray(postingCount - 1)
+            postings.copyInto(shrunk, 0, postingFrom, position)
+            postings.copyInto(shrunk, position - postingFrom, position + 1, end)
+            return copy(postings = shrunk, postingFrom = 0, postingCount = postingCount - 1)
+        }
+        
+        fun withChild(at: Int, child: RadixNode): RadixNode =
+            copy(children = children.copyOf().also { it[at] = child })
+        
+        fun withNewChild(at: Int, child: RadixNode): RadixNode {
+            val size = keys.size
+            val newKeys = CharArray(size + 1)
+            keys.copyInto(newKeys, 0, 0, at)
+            newKeys[at] = child.label[0]
+            keys.copyInto(newKeys, at + 1, at, size)
+            val newChildren = Array(size + 1) { i ->
+                when {
+                    i < at -> children[i]
+                    i == at -> child
+                    else -> children[i - 1]
+                }
+            }
+            return copy(keys = newKeys, children = newChildren)
+        }
+        
+        fun withoutChild(at: Int): RadixNode = copy(
+            keys = keys.copyOfRange(0, at) + keys.copyOfRange(at + 1, keys.size),
+            children = Array(children.size - 1) { i -> if (i < at) children[i] else children[i + 1] }
+        )
+        
+        /**
+         * Split the edge after [at] chars; the new upper node shares this
+         * node's postings and top list, since every word below passes it.
+         */
+        fun split(at: Int): RadixNode {
+            val rest = copy(label = label.substring(at))
+            return RadixNode(
+                label = label.substring(0, at),
+                keys = charArrayOf(rest.label[0]),
+                children = arrayOf(rest),
+                postings = postings,
+                postingFrom = postingFrom,
+                postingCount = postingCount,
+                top = top
+            )
+        }
+        
+        // A non-terminal node with one child is redundant in a radix trie
+        fun mergeWithOnlyChild(): RadixNode {
+            val only = children[0]
+            return only.copy(label = label + only.label)
+        }
+        
+        companion object {
+            val NO_KEYS = CharArray(0)
+            val NO_CHILDREN = emptyArray<RadixNode>()
+            val NO_POSTINGS = IntArray(0)
+        }
     }
     
-    private var root = TrieNode()
-    private var size = 0
+    /**
+     * Persistent ordinal -> snack table. An update copies the chunk spine
+     * and a single chunk; every other chunk is shared with older snapshots.
+     */
+    private class SnackTable(private val chunks: Array<Array<Snack?>>) {
+        
+        operator fun get(ordinal: Int): Snack =
+            chunks[ordinal ushr CHUNK_SHIFT][ordinal and CHUNK_MASK]!!
+        
+        // Slots allocated so far, including freed ones
+        val capacity: Int get() = chunks.size shl CHUNK_SHIFT
+        
+        fun getOrNull(ordinal: Int): Snack? =
+            chunks.getOrNull(ordinal ushr CHUNK_SHIFT)?.get(ordinal and CHUNK_MASK)
+        
+        fun set(ordinal: Int, snack: Snack?): SnackTable {
+            val index = ordinal ushr CHUNK_SHIFT
+            val spine = Array(maxOf(chunks.size, index + 1)) { i ->
+                if (i < chunks.size) chunks[i] else arrayOfNulls<Snack>(CHUNK_SIZE)
+            }
+            spine[index] = spine[index].copyOf().also { it[ordinal and CHUNK_MASK] = snack }
+            return SnackTable(spine)
+        }
+        
+        // Ties fall back to ordinal so the top list and the tail agree on order
+        fun compare(ranking: Comparator<Snack>, a: Int, b: Int): Int {
+            val byRank = ranking.compare(get(a), get(b))
+            return if (byRank != 0) byRank else a.compareTo(b)
+        }
+        
+        companion object {
+            const val CHUNK_SHIFT = 6
+            const val CHUNK_SIZE = 1 shl CHUNK_SHIFT
+            const val CHUNK_MASK = CHUNK_SIZE - 1
+            val EMPTY = SnackTable(emptyArray())
+            
+            fun of(slots: Array<Snack?>): SnackTable = SnackTable(
+                Array((slots.size + CHUNK_MASK) ushr CHUNK_SHIFT) { chunk ->
+                    Array(CHUNK_SIZE) { slots.getOrNull((chunk shl CHUNK_SHIFT) + it) }
+                }
+            )
+        }
+    }
+    
+    /**
+     * Per-ordinal availability, vegetarian and in-stock bits, one LongArray
+     * per flag. Flags are not part of the ranking key, so results are
+     * filtered against them at read time instead of being re-indexed.
+     */
+    private class SnackFlags(
+        private val available: LongArray,
+        private val vegetarian: LongArray,
+        private val inStock: LongArray
+    ) {
+        
+        /**
+         * Copy with [ordinal]'s bits taken from [snack], cleared for null.
+         * Only bitsets whose bit actually changes are copied.
+         * Time: O(n / 64)
+         */
+        fun set(ordinal: Int, snack: Snack?): SnackFlags = SnackFlags(
+            available.with(ordinal, snack?.isAvailable == true),
+            vegetarian.with(ordinal, snack?.isVegetarian == true),
+            inStock.with(ordinal, snack != null && snack.stockQuantity > 0)
+        )
+        
+        /**
+         * AND of the bitsets [filter] requires, one 64-bit word at a time.
+         * Null when the filter requires nothing.
+         * Time: O(n / 64)
+         */
+        fun mask(filter: SnackSearchFilter): LongArray? {
+            val required = listOfNotNull(
+                available.takeUnless { filter.includeUnavailable },
+                vegetarian.takeIf { filter.vegetarianOnly },
+                inStock.takeIf { filter.inStockOnly }
+            )
+            if (required.isEmpty()) return null
+            
+            return LongArray(required.minOf { it.size }) { word ->
+                required.fold(-1L) { bits, flag -> bits and flag[word] }
+            }
+        }
+        
+        private fun LongArray.with(ordinal: Int, value: Boolean): LongArray {
+            val word = ordinal ushr 6
+            val bit = 1L shl ordinal
+            val current = word < size && (this[word] and bit) != 0L
+            if (current == value) return this
+            
+            val copy = if (word < size) copyOf() else copyOf(word + 1)
+            copy[word] = if (value) copy[word] or bit else copy[word] and bit.inv()
+            return copy
+        }
+        
+        companion object {
+            val EMPTY = SnackFlags(LongArray(0), LongArray(0), LongArray(0))
+            
+            /**
+             * Flags for ordinals `0 until count` in one pass.
+             * Time: O(n)
+             */
+            fun of(count: Int, snackAt: (Int) -> Snack?): SnackFlags {
+                val words = (count + 63) ushr 6
+                val available = LongArray(words)
+                val vegetarian = LongArray(words)
+                val inStock = LongArray(words)
+                for (ordinal in 0 until count) {
+                    val snack = snackAt(ordinal) ?: continue
+                    val bit = 1L shl ordinal
+                    val word = ordinal ushr 6
+                    if (snack.isAvailable) available[word] = available[word] or bit
+                    if (snack.isVegetarian) vegetarian[word] = vegetarian[word] or bit
+                    if (snack.stockQuantity > 0) inStock[word] = inStock[word] or bit
+                }
+                return SnackFlags(available, vegetarian, inStock)
+            }
+        }
+    }
+    
+    /**
+     * Persistent phonetic key -> ordinals map. Keys are packed
+     * [SnackPhonetics] Longs hashed into [BUCKETS] buckets; each bucket is
+     * a small sorted LongArray with parallel posting arrays, so a lookup is
+     * one hash plus a short binary search. An update copies the bucket
+     * spine and one bucket; the rest is shared with older snapshots.
+     */
+    private class PhoneticIndex(private val buckets: Array<PhoneticBucket>) {
+        
+        operator fun get(key: Long): IntArray = buckets[bucketOf(key)][key]
+        
+        fun add(key: Long, ordinal: Int): PhoneticIndex = replace(key, buckets[bucketOf(key)].add(key, ordinal))
+        
+        fun remove(key: Long, ordinal: Int): PhoneticIndex = replace(key, buckets[bucketOf(key)].remove(key, ordinal))
+        
+        private fun replace(key: Long, bucket: PhoneticBucket): PhoneticIndex {
+            val index = bucketOf(key)
+            if (bucket === buckets[index]) return this
+            return PhoneticIndex(buckets.copyOf().also { it[index] = bucket })
+        }
+        
+        companion object {
+            const val BUCKETS = 256
+            val EMPTY = PhoneticIndex(Array(BUCKETS) { PhoneticBucket.EMPTY })
+            
+            // Multiplicative hash; the top 8 bits pick the bucket
+            fun bucketOf(key: Long): Int = ((key * -7046029254386353131L) ushr 56).toInt()
+            
+            /**
+             * Index for ordinals `0 until count` in one pass.
+             * Time: O(w log w) over w phonetic keys
+             */
+            fun of(count: Int, keysAt: (Int) -> Collection<Long>): PhoneticIndex {
+                val postings = HashMap<Long, ArrayList<Int>>()
+                for (ordinal in 0 until count) {
+                    keysAt(ordinal).forEach { key -> postings.getOrPut(key) { ArrayList() }.add(ordinal) }
+                }
+                
+                val grouped = postings.keys.sorted().groupBy { bucketOf(it) }
+                return PhoneticIndex(Array(BUCKETS) { index ->
+                    val keys = grouped[index] ?: return@Array PhoneticBucket.EMPTY
+                    PhoneticBucket(
+                        keys.toLongArray(),
+                        Array(keys.size) { postings.getValue(keys[it]).toIntArray() }
+                    )
+                })
+            }
+        }
+    }
+    
+    // Sorted keys with one sorted ordinal array each
+    private class PhoneticBucket(private val keys: LongArray, private val postings: Array<IntArray>) {
+        
+        operator fun get(key: Long): IntArray {
+            val at = indexOf(key)
+            return if (at >= 0) postings[at] else RadixNode.NO_POSTINGS
+        }
+        
+        fun add(key: Long, ordinal: Int): PhoneticBucket {
+            val at = indexOf(key)
+            if (at >= 0) {
+                val updated = PostingLists.insert(postings[at], ordinal)
+                if (updated === postings[at]) return this
+                return PhoneticBucket(keys, postings.copyOf().also { it[at] = updated })
+            }
+            
+            val insertAt = -(at + 1)
+            val newKeys = LongArray(keys.size + 1) { i ->
+                when {
+                    i < insertAt -> keys[i]
+                    i == insertAt -> key
+                    else -> keys[i - 1]
+                }
+            }
+            val newPostings = Array(keys.size + 1) { i ->
+                when {
+                    i < insertAt -> postings[i]
+                    i == insertAt -> intArrayOf(ordinal)
+                    else -> postings[i - 1]
+                }
+            }
+            return PhoneticBucket(newKeys, newPostings)
+        }
+        
+        fun remove(key: Long, ordinal: Int): PhoneticBucket {
+            val at = indexOf(key)
+            if (at < 0) return this
+            val updated = PostingLists.remove(postings[at], ordinal)
+            if (updated === postings[at]) return this
+            if (updated.isNotEmpty()) {
+                return PhoneticBucket(keys, postings.copyOf().also { it[at] = updated })
+            }
+            
+            val newKeys = LongArray(keys.size - 1) { i -> if (i < at) keys[i] else keys[i + 1] }
+            val newPostings = Array(keys.size - 1) { i -> if (i < at) postings[i] else postings[i + 1] }
+            return PhoneticBucket(newKeys, newPostings)
+        }
+        
+        private fun indexOf(key: Long): Int {
+            var low = 0
+            var high = keys.size - 1
+            while (low <= high) {
+                val mid = (low + high) ushr 1
+                when {
+                    keys[mid] < key -> low = mid + 1
+                    keys[mid] > key -> high = mid - 1
+                    else -> return mid
+                }
+            }
+            return -(low + 1)
+        }
+        
+        companion object {
+            val EMPTY = PhoneticBucket(LongArray(0), emptyArray())
+        }
+    }
+    
+    /**
+     * One immutable, published version of the index. Flag-only writes
+     * publish a new version with the same [root] and [generation];
+     * selection counts change [root] and [weights] but keep [generation],
+     * since postings and top lists are untouched.
+     */
+    private class Snapshot(
+        val root: RadixNode,
+        val table: SnackTable,
+        val flags: SnackFlags,
+        val phonetics: PhoneticIndex,
+        val ranking: Comparator<Snack>,
+        val size: Int,
+        val generation: Int,
+        // Bumped whenever completion weights may have changed
+        val weights: Int
+    ) {
+        fun rankedPostings(node: RadixNode): IntArray {
+            val ordinals = Array(node.postingCount) { node.postings[node.postingFrom + it] }
+            ordinals.sortWith(Comparator { a, b -> table.compare(ranking, a, b) })
+            return ordinals.toIntArray()
+        }
+    }
+    
+    private val published = atomic(
+        Snapshot(RadixNode(""), SnackTable.EMPTY, SnackFlags.EMPTY, PhoneticIndex.EMPTY, ranking, 0, 0, 0)
+    )
+    private val writeLock = SynchronizedObject()
+    
+    // Writer-side bookkeeping, guarded by writeLock; readers never touch it
+    private val ordinalById = HashMap<String, Int>()
+    private val freeOrdinals = ArrayList<Int>()
+    private var nextOrdinal = 0
+    
+    // Selections not yet counted, applied by the next write
+    private val pendingSelections = ArrayList<PendingSelection>()
+    
+    // Memoized suggestions of one weights version, replaced as a whole
+    private val suggestionMemo = atomic(SuggestionMemo(-1, emptyMap()))
     
     /**
      * Insert a snack into the trie.
      * Indexes by name and tags for comprehensive search.
+     * Re-inserting a known id replaces the snack in place.
+     * 
+     * Time: O(k) where k is total indexed text length
+     */
+    fun insert(snack: Snack) = write { insertSnack(snack) }
+    
+    /**
+     * Remove a snack and every posting that points at it.
+     * Nodes left without postings are pruned and pass-through nodes are
+     * merged back into their only child.
+     * 
+     * Time: O(k + m) per indexed word of the snack
+     */
+    fun remove(snackId: String): Boolean = write { removeSnack(snackId) }
+    
+    /**
+     * Replace an indexed snack. Only the paths of its old and new words are
+     * touched; unchanged words are just re-ranked in place.
+     * 
+     * Time: O(k + m) per indexed word of old and new
+     */
+    fun update(old: Snack, new: Snack) = write { updateSnack(old, new) }
+    
+    /**
+     * Bring the index in line with a full catalog snapshot, e.g. an
+     * observeSnacks() emission, touching only snacks that changed.
+     * All changes are published as one version.
+     * 
+     * Each incremental insert or removal copies the posting lists along
+     * its words' paths, so a cold index, or a diff that restructures more
+     * than 1/[BULK_SYNC_DIVISOR] of the catalog, is bulk-loaded as in
+     * [build] instead. Query hits carry over; flag-only changes never
+     * count towards the threshold.
      * 
-     * Time: O(k) where k is name length
+     * Time: O(n) comparisons + O(changed words), or O(E log E + P log K) bulk
+     */
+    fun applySnapshot(snacks: List<Snack>) = write {
+        val incoming = snacks.associateBy { it.id }
+        val removed = ordinalById.keys.filter { it !in incoming }
+        val changed = incoming.values.filter { snack ->
+            val ordinal = ordinalById[snack.id]
+            ordinal == null || table[ordinal] != snack
+        }
+        
+        val restructured = removed.size + changed.count { snack ->
+            val ordinal = ordinalById[snack.id]
+            ordinal == null || !isFlagOnlyChange(table[ordinal], snack)
+        }
+        // An empty index has size 0, so any insert bulk-loads it
+        if (restructured > 0 && restructured * BULK_SYNC_DIVISOR > ordinalById.size) {
+            reload(incoming.values)
+            return@write
+        }
+        
+        removed.forEach { removeSnack(it) }
+        changed.forEach { snack ->
+            val ordinal = ordinalById[snack.id]
+            if (ordinal == null) insertSnack(snack) else updateSnack(table[ordinal], snack)
+        }
+    }
+    
+    /**
+     * Change the result ranking, e.g. after new order history arrives.
+     * An equal ranking is a no-op.
+     * Time: O(P K) where P is total postings
+     */
+    fun setRanking(ranking: Comparator<Snack>) = write {
+        if (this.ranking == ranking) return@write
+        this.ranking = ranking
+        root = rerank(root)
+    }
+    
+    /**
+     * Flip a snack's availability. Only its flag bits change; nodes, top
+     * lists and open sessions are left as they are.
+     * 
+     * Time: O(n / 64)
+     */
+    fun setAvailability(snackId: String, isAvailable: Boolean): Boolean = write {
+        val ordinal = ordinalById[snackId] ?: return@write false
+        updateFlags(ordinal, table[ordinal].copy(isAvailable = isAvailable))
+        true
+    }
+    
+    /**
+     * Update a snack's stock count; see [setAvailability].
+     * Time: O(n / 64)
+     */
+    fun setStockQuantity(snackId: String, quantity: Int): Boolean = write {
+        val ordinal = ordinalById[snackId] ?: return@write false
+        updateFlags(ordinal, table[ordinal].copy(stockQuantity = quantity))
+        true
+    }
+    
+    /**
+     * Count a pick of [snack] from the results of [query], for autocomplete
+     * ranking: each word of the snack that a query term prefixes gains one
+     * query hit ("mag" + Maggi -> "maggi").
+     * 
+     * Picks are buffered and counted in batches of [SELECTION_BATCH], or by
+     * the next write, so a pick does not publish a version of its own.
+     * Counting keeps the generation: sessions stay valid.
+     * 
+     * Time: O(1) amortized, O(b t k) path copies per batch of b picks
+     */
+    fun recordSelection(query: String, snack: Snack) {
+        val terms = parseTerms(query)
+        if (terms.isEmpty()) return
+        
+        val full = synchronized(writeLock) {
+            pendingSelections.add(PendingSelection(terms, snack))
+            pendingSelections.size >= SELECTION_BATCH
+        }
+        if (full) flushSelections()
+    }
+    
+    /**
+     * Count buffered picks now, e.g. before persisting the index.
+     * Time: O(b t k)
+     */
+    fun flushSelections() = write { }
+    
+    private class PendingSelection(val terms: List<String>, val snack: Snack)
+    
+    /**
+     * Search for snacks by prefix.
+     * Returns all snacks passing [filter] whose name/tag starts with the
+     * prefix, best-ranked first.
+     * 
+     * Time: O(k + n / 64 + m log m) where k is prefix length, m is results
+     */
+    fun search(prefix: String, filter: SnackSearchFilter = SnackSearchFilter.DEFAULT): List<Snack> {
+        val key = SnackTextNormalizer.fold(prefix)
+        if (key.isEmpty()) return emptyList()
+        
+        val snapshot = published.value
+        val node = locate(snapshot.root, key)?.node ?: return emptyList()
+        val mask = snapshot.flags.mask(filter)
+        
+        // Postings are distinct ordinals, so no dedupe pass is needed
+        return snapshot.rankedPostings(node)
+            .filter { mask.admits(it) }
+            .map { snapshot.table[it] }
+    }
+    
+    /**
+     * Multi-term search ("veg cold coffee", "maggi masala").
+     * 
+     * Each term is resolved to its node's sorted posting range, and the
+     * ranges are intersected smallest-first with galloping search. If fewer
+     * than [limit] snacks match every term, snacks matching only some terms
+     * fill the rest. Results are ordered by terms matched, then by the field
+     * each term matched (name > tag > category), then by ranking.
+     * 
+     * Time: O(t k + s log(l / s) + c t) where t is terms, s and l are the
+     *       shortest and longest lists, c is candidates scored
+     */
+    fun searchTerms(
+        query: String,
+        limit: Int = topK,
+        filter: SnackSearchFilter = SnackSearchFilter.DEFAULT
+    ): List<Snack> {
+        val terms = parseTerms(query)
+        if (terms.isEmpty()) return emptyList()
+        
+        val snapshot = published.value
+        val mask = snapshot.flags.mask(filter)
+        
+        // Smallest list first keeps every intermediate result at most that size
+        val lists = terms.mapNotNull { locate(snapshot.root, it)?.node }.sortedBy { it.postingCount }
+        val matchingAll = if (lists.size == terms.size) intersectAll(lists) else RadixNode.NO_POSTINGS
+        
+        // ordinal -> number of terms matched
+        val matched = HashMap<Int, Int>()
+        matchingAll.forEach { if (mask.admits(it)) matched[it] = terms.size }
+        
+        if (matched.size < limit && terms.size > 1) {
+            for (node in lists) {
+                for (i in node.postingFrom until node.postingFrom + node.postingCount) {
+                    val ordinal = node.postings[i]
+                    val count = matched[ordinal] ?: 0
+                    if (count < terms.size && mask.admits(ordinal)) matched[ordinal] = count + 1
+                }
+            }
+        }
+        
+        return matched.entries
+            .map { (ordinal, count) -> TermMatch(ordinal, count, fieldScore(snapshot.table[ordinal], terms)) }
+            .sortedWith(Comparator { a, b ->
+                when {
+                    a.terms != b.terms -> b.terms.compareTo(a.terms)
+                    a.fieldScore != b.fieldScore -> b.fieldScore.compareTo(a.fieldScore)
+                    else -> snapshot.table.compare(snapshot.ranking, a.ordinal, b.ordinal)
+                }
+            })
+            .take(limit)
+            .map { snapshot.table[it.ordinal] }
+    }
+    
+    private class TermMatch(val ordinal: Int, val terms: Int, val fieldScore: Int)
+    
+    private fun intersectAll(lists: List<RadixNode>): IntArray {
+        val first = lists[0]
+        var result = first.postings.copyOfRange(first.postingFrom, first.postingFrom + first.postingCount)
+        
+        for (i in 1 until lists.size) {
+            if (result.isEmpty()) break
+            val node = lists[i]
+            result = PostingLists.intersect(
+                result, 0, result.size,
+                node.postings, node.postingFrom, node.postingFrom + node.postingCount
+            )
+        }
+        return result
+    }
+    
+    /**
+     * Sum over terms of the best field the term prefixes.
+     * Time: O(t f) where f is the snack's indexed text length
      */
-    fun insert(snack: Snack) {
-        // Insert by name
-        insertWord(snack.name.lowercase(), snack)
+    private fun fieldScore(snack: Snack, terms: List<String>): Int {
+        val name = SnackTextNormalizer.fold(snack.name)
+        val tags = snack.tags.map { SnackTextNormalizer.fold(it) }
+        val category = SnackTextNormalizer.fold(snack.category.name)
+        
+        return terms.sumOf { term ->
+            when {
+                prefixesText(name, term) -> NAME_FIELD_SCORE
+                tags.any { prefixesText(it, term) } -> TAG_FIELD_SCORE
+                category.startsWith(term) -> CATEGORY_FIELD_SCORE
+                else -> 0
+            }
+        }
+    }
+    
+    // True if [term] prefixes the whole text or any of its words
+    private fun prefixesText(text: String, term: String): Boolean =
+        text.startsWith(term) || text.split(' ').any { it.startsWith(term) }
+    
+    /**
+     * Sound-alike search ("samossa" -> Samosa, "kachauri" -> Kachori,
+     * "chay" -> Chai), meant as a fallback when prefix matching is thin.
+     * 
+     * Every query term must share a [SnackPhonetics] key with a word of the
+     * snack. Keys are packed Longs kept per snapshot, so each term is one
+     * hash probe; terms are intersected smallest list first.
+     * 
+     * Time: O(t k + s log(l / s) + m log m) where m is matches
+     */
+    fun searchPhonetic(
+        query: String,
+        limit: Int = topK,
+        filter: SnackSearchFilter = SnackSearchFilter.DEFAULT
+    ): List<Snack> {
+        val snapshot = published.value
+        val lists = parseTerms(query)
+            .map { SnackPhonetics.key(it) }
+            .filter { it != 0L }
+            .map { snapshot.phonetics[it] }
+            .sortedBy { it.size }
+        if (lists.isEmpty()) return emptyList()
+        
+        var matches = lists[0]
+        for (i in 1 until lists.size) {
+            if (matches.isEmpty()) break
+            matches = PostingLists.intersect(matches, 0, matches.size, lists[i], 0, lists[i].size)
+        }
+        
+        val mask = snapshot.flags.mask(filter)
+        return matches
+            .filter { mask.admits(it) }
+            .sortedWith(Comparator { a, b -> snapshot.table.compare(snapshot.ranking, a, b) })
+            .take(limit)
+            .map { snapshot.table[it] }
+    }
+    
+    /**
+     * Typo-tolerant prefix search ("magi", "maggie" -> Maggi, "coffe" -> Coffee).
+     * 
+     * Walks the trie with a bounded Damerau-Levenshtein automaton: one DP row
+     * per path char, with adjacent transpositions. A branch is abandoned as
+     * soon as its rows exceed [maxEdits], and a node whose row accepts the
+     * whole query contributes its cached top list at that distance, or all
+     * of its postings when [filter] is active or the top list is short.
+     * Filtered-out snacks are skipped while collecting, so they never
+     * crowd out matches. Results are ordered by edit distance, then by ranking.
+     * 
+     * Time: O(V q) where V is trie chars visited before pruning, q is query length
+     */
+    fun searchFuzzy(
+        query: String,
+        maxEdits: Int = fuzzyEditBudget(query.trim().length),
+        limit: Int = topK,
+        filter: SnackSearchFilter = SnackSearchFilter.DEFAULT
+    ): List<Snack> {
+        val term = SnackTextNormalizer.fold(query)
+        if (term.isEmpty()) return emptyList()
+        
+        val snapshot = published.value
+        val mask = snapshot.flags.mask(filter)
+        val walker = FuzzyWalker(term, maxEdits, limit, mask?.let { { ordinal: Int -> it.admits(ordinal) } })
+        walker.walk(snapshot.root)
+        
+        return walker.matches.entries
+            .sortedWith(Comparator { a, b ->
+                val byDistance = a.value.compareTo(b.value)
+                if (byDistance != 0) byDistance else snapshot.table.compare(snapshot.ranking, a.key, b.key)
+            })
+            .asSequence()
+            .map { snapshot.table[it.key] }
+            .take(limit)
+            .toList()
+    }
+    
+    /**
+     * Depth-first Levenshtein automaton over radix edges.
+     * rows[j] is the edit distance row after j path chars.
+     * [admits] is the active filter, null when nothing is filtered out.
+     */
+    private class FuzzyWalker(
+        private val query: String,
+        private val maxEdits: Int,
+        private val limit: Int,
+        private val admits: ((Int) -> Boolean)?
+    ) {
+        // ordinal -> best edit distance seen
+        val matches = HashMap<Int, Int>()
+        
+        private val rows = ArrayList<IntArray>()
+        private var path = CharArray(32)
+        
+        fun walk(root: RadixNode) {
+            row(0).let { first -> for (i in first.indices) first[i] = i }
+            root.children.forEach { visit(it, 0) }
+        }
+        
+        private fun visit(node: RadixNode, depth: Int) {
+            val q = query.length
+            var j = depth
+            var accepted = Int.MAX_VALUE
+            var recentMin = Int.MAX_VALUE
+            var pruned = false
+            
+            for (c in node.label) {
+                j++
+                recentMin = step(j, c)
+                accepted = minOf(accepted, rows[j][q])
+                if (recentMin > maxEdits) {
+                    pruned = true
+                    break
+                }
+            }
+            
+            // The prefix ended somewhere on this edge: every word below matches
+            if (accepted <= maxEdits) collect(node, accepted)
+            
+            // Later cells never drop below the minimum of the last rows
+            if (pruned || accepted == 0 || recentMin >= accepted) return
+            node.children.forEach { visit(it, j) }
+        }
+        
+        /**
+         * Fill rows[j] for path char [c]; returns the minimum over rows j-1 and j,
+         * which bounds every cell below this point.
+         */
+        private fun step(j: Int, c: Char): Int {
+            if (j > path.size) path = path.copyOf(path.size * 2)
+            path[j - 1] = c
+            
+            val previous = rows[j - 1]
+            val current = row(j)
+            current[0] = j
+            var rowMin = j
+            
+            for (i in 1..query.length) {
+                val cost = if (query[i - 1] == c) 0 else 1
+                var cell = minOf(previous[i] + 1, current[i - 1] + 1, previous[i - 1] + cost)
+                
+                // Adjacent transposition ("cofefe" style swaps)
+                if (i > 1 && j > 1 && query[i - 1] == path[j - 2] && query[i - 2] == c) {
+                    cell = minOf(cell, rows[j - 2][i - 2] + 1)
+                }
+                current[i] = cell
+                if (cell < rowMin) rowMin = cell
+            }
+            return minOf(rowMin, previous.min())
+        }
+        
+        private fun row(j: Int): IntArray {
+            while (rows.size <= j) rows.add(IntArray(query.length + 1))
+            return rows[j]
+        }
+        
+        private fun collect(node: RadixNode, distance: Int) {
+            // An unfiltered top list holding min(limit, m) entries has the node's best
+            // `limit`; deletes can leave it shorter, and filters can empty it
+            if (admits == null && node.top.size >= minOf(limit, node.postingCount)) {
+                node.top.forEach { offer(it, distance) }
+                return
+            }
+            for (i in node.postingFrom until node.postingFrom + node.postingCount) {
+                val ordinal = node.postings[i]
+                if (admits == null || admits.invoke(ordinal)) offer(ordinal, distance)
+            }
+        }
+        
+        private fun offer(ordinal: Int, distance: Int) {
+            val known = matches[ordinal]
+            if (known == null || distance < known) matches[ordinal] = distance
+        }
+    }
+    
+    /**
+     * Get autocomplete suggestions.
+     * Returns word completions for the given prefix, heaviest first: how
+     * often the word was picked from search plus units sold of its snacks.
+     * 
+     * Every node caches the best weight in its subtree, so completions are
+     * collected best-first from a queue bounded to the words still needed:
+     * a branch is only opened once it can beat what is already queued.
+     * Results for hot prefixes are memoized, lock-free, until completion
+     * weights change.
+     * 
+     * Time: O(k + limit σ log limit), O(1) when memoized
+     */
+    fun getSuggestions(prefix: String, limit: Int = 10): List<String> {
+        if (prefix.isBlank() || limit <= 0) return emptyList()
+        
+        val lowerPrefix = SnackTextNormalizer.fold(prefix)
+        if (lowerPrefix.isEmpty()) return emptyList()
+        val snapshot = published.value
+        val key = "$limit:$lowerPrefix"
+        cachedSuggestions(snapshot, key)?.let { return it }
+        
+        val match = locate(snapshot.root, lowerPrefix) ?: return emptyList()
+        
+        // The prefix may stop part-way through the node's edge label
+        val path = StringBuilder(lowerPrefix)
+            .appendRange(match.node.label, match.labelOffset, match.node.label.length)
+            .toString()
+        
+        val suggestions = collectCompletions(match.node, path, limit)
+        memoizeSuggestions(snapshot, key, suggestions)
+        return suggestions
+    }
+    
+    private fun cachedSuggestions(snapshot: Snapshot, key: String): List<String>? {
+        val memo = suggestionMemo.value
+        return if (memo.weights == snapshot.weights) memo.entries[key] else null
+    }
+    
+    /**
+     * Publish a copy of the memo with [key] added; a memo of older weights
+     * is dropped, one of newer weights is left alone. Lock-free: a lost
+     * race just retries the copy.
+     * Time: O(SUGGESTION_CACHE_SIZE)
+     */
+    private fun memoizeSuggestions(snapshot: Snapshot, key: String, suggestions: List<String>) {
+        while (true) {
+            val memo = suggestionMemo.value
+            if (memo.weights > snapshot.weights) return
+            
+            val entries = LinkedHashMap<String, List<String>>()
+            if (memo.weights == snapshot.weights) entries.putAll(memo.entries)
+            entries[key] = suggestions
+            // Oldest first, so the first key is the least recently added
+            if (entries.size > SUGGESTION_CACHE_SIZE) entries.remove(entries.keys.first())
+            
+            if (suggestionMemo.compareAndSet(memo, SuggestionMemo(snapshot.weights, entries))) return
+        }
+    }
+    
+    private class SuggestionMemo(val weights: Int, val entries: Map<String, List<String>>)
+    
+    private fun collectCompletions(start: RadixNode, path: String, limit: Int): List<String> {
+        val results = ArrayList<String>(limit)
+        val queue = CompletionQueue()
+        queue.offer(Completion(start, path, start.bestWeight, isWord = false), limit)
+        
+        while (results.size < limit && queue.isNotEmpty()) {
+            val next = queue.poll()
+            if (next.isWord) {
+                results.add(next.path)
+                continue
+            }
+            
+            val node = next.node
+            val capacity = limit - results.size
+            if (node.isEndOfWord) {
+                queue.offer(Completion(node, next.path, node.weight, isWord = true), capacity)
+            }
+            for (child in node.children) {
+                queue.offer(Completion(child, next.path + child.label, child.bestWeight, isWord = false), capacity)
+            }
+        }
+        return results
+    }
+    
+    /**
+     * A word, or a whole subtree keyed by its best completion weight.
+     * Queued entries never overlap, so each one is worth at least one word.
+     */
+    private class Completion(
+        val node: RadixNode,
+        val path: String,
+        val weight: Int,
+        val isWord: Boolean
+    )
+    
+    /**
+     * Completions sorted best first, trimmed to the number still needed:
+     * the first `capacity` entries already promise that many words, so
+     * anything ranked after them can never be returned.
+     */
+    private class CompletionQueue {
+        private val entries = ArrayList<Completion>()
+        
+        fun isNotEmpty(): Boolean = entries.isNotEmpty()
+        
+        fun poll(): Completion = entries.removeAt(0)
+        
+        fun offer(entry: Completion, capacity: Int) {
+            var low = 0
+            var high = entries.size
+            while (low < high) {
+                val mid = (low + high) ushr 1
+                if (before(entries[mid], entry)) low = mid + 1 else high = mid
+            }
+            if (low >= capacity) return
+            
+            entries.add(low, entry)
+            while (entries.size > capacity) entries.removeAt(entries.size - 1)
+        }
+        
+        // Heavier first, then alphabetical; a word before its own extensions
+        private fun before(a: Completion, b: Completion): Boolean = when {
+            a.weight != b.weight -> a.weight > b.weight
+            a.path != b.path -> a.path < b.path
+            else -> a.isWord && !b.isWord
+        }
+    }
+    
+    /**
+     * Node reached by a prefix, plus how far into its edge label the prefix ended.
+     */
+    private class PrefixMatch(val node: RadixNode, val labelOffset: Int)
+    
+    private fun locate(root: RadixNode, prefix: String): PrefixMatch? {
+        var current = root
+        var offset = 0
+        
+        while (offset < prefix.length) {
+            val slot = current.childIndex(prefix[offset])
+            if (slot < 0) return null
+            
+            val child = current.children[slot]
+            val common = commonPrefixLength(child.label, prefix, offset)
+            
+            if (offset + common == prefix.length) {
+                return PrefixMatch(child, common)
+            }
+            if (common < child.label.length) return null
+            
+            offset += common
+            current = child
+        }
+        
+        return PrefixMatch(current, current.label.length)
+    }
+    
+    private fun commonPrefixLength(label: String, word: String, offset: Int): Int {
+        val max = minOf(label.length, word.length - offset)
+        var i = 0
+        while (i < max && label[i] == word[offset + i]) i++
+        return i
+    }
+    
+    /**
+     * Clear the trie.
+     * Time: O(1)
+     */
+    fun clear() = write {
+        root = RadixNode("")
+        table = SnackTable.EMPTY
+        flags = SnackFlags.EMPTY
+        phonetics = PhoneticIndex.EMPTY
+        ordinalById.clear()
+        freeOrdinals.clear()
+        nextOrdinal = 0
+    }
+    
+    fun getSize(): Int = published.value.size
+    
+    /**
+     * Version of the published index; bumps whenever results can change order.
+     */
+    fun getVersion(): Int = published.value.generation
+    
+    /**
+     * Version of what [writeBinary] stores beyond flags: words, postings,
+     * ranking and query hits. Availability and stock flips keep it, so
+     * callers can skip persisting when it has not moved.
+     */
+    fun getContentVersion(): Int = published.value.weights
+    
+    /**
+     * Open a type-ahead session; see [SearchSession].
+     * Time: O(1)
+     */
+    fun openSession(): SearchSession = SearchSession()
+    
+    // ==========================================
+    // SEARCH SESSIONS
+    // ==========================================
+    
+    /**
+     * One typed char of a session: the node reached, how far into its edge
+     * label, and (once needed) its ordinals in rank order, before filtering.
+     */
+    private class SessionFrame(val node: RadixNode?, val labelOffset: Int) {
+        var ranked: IntArray? = null
+    }
+    
+    /**
+     * Keystroke-incremental search for a single input field.
+     * 
+     * Keeps a stack with one frame per char of the folded query (see
+     * [SnackTextNormalizer]). Appending a char advances one step along the
+     * current edge label or into a child; backspace pops a frame. A longer query's results are a subset of the shorter one's,
+     * so they are narrowed from the previous frame by membership, keeping
+     * rank order without sorting again. Frames on the same edge share one
+     * result set.
+     * 
+     * A session reads one published version. If a writer changes the trie,
+     * the query is replayed against it on the next call; flag-only writes
+     * just swap in the new flags. Not thread-safe.
+     */
+    inner class SearchSession internal constructor() {
+        
+        private var snapshot = published.value
+        private val frames = arrayListOf(rootFrame(snapshot))
+        private val raw = StringBuilder()
+        
+        // Folded query; frames[i + 1] is the step for typed[i]
+        private val typed = StringBuilder()
+        
+        val query: String get() = raw.toString()
+        
+        /**
+         * Time: O(k) table-driven fold, then O(1) trie steps for a plain char
+         */
+        fun append(char: Char) {
+            raw.append(char)
+            moveTo(SnackTextNormalizer.fold(raw))
+        }
+        
+        /**
+         * Time: O(k) table-driven fold, then O(1) trie steps for a plain char
+         */
+        fun backspace() {
+            if (raw.isEmpty()) return
+            raw.setLength(raw.length - 1)
+            moveTo(SnackTextNormalizer.fold(raw))
+        }
+        
+        /**
+         * Move to a new query, e.g. the latest text field value.
+         * Time: O(k + d) where d is the number of folded chars that differ
+         */
+        fun setQuery(query: String) {
+            raw.setLength(0)
+            raw.append(query)
+            moveTo(SnackTextNormalizer.fold(raw))
+        }
+        
+        fun clear() = setQuery("")
+        
+        // Pop back to the common prefix with the target, then step through the rest
+        private fun moveTo(target: String) {
+            refresh()
+            val common = commonPrefixLength(typed.toString(), target, 0)
+            while (typed.length > common) {
+                typed.setLength(typed.length - 1)
+                frames.removeAt(frames.lastIndex)
+            }
+            for (i in common until target.length) {
+                typed.append(target[i])
+                frames.add(advance(frames.last(), target[i]))
+            }
+        }
+        
+        /**
+         * Best-ranked available results for the current query.
+         * Served from the node's cached top list when it covers [limit].
+         * 
+         * Time: O(limit) from the top list, otherwise see [allResults]
+         */
+        fun results(
+            limit: Int = topK,
+            filter: SnackSearchFilter = SnackSearchFilter.DEFAULT
+        ): List<Snack> {
+            refresh()
+            if (typed.isBlank()) return emptyList()
+            val frame = frames.last()
+            val node = frame.node ?: return emptyList()
+            val mask = snapshot.flags.mask(filter)
+            
+            if (frame.ranked == null) {
+                val results = ArrayList<Snack>(minOf(limit, node.top.size))
+                for (ordinal in node.top) {
+                    if (mask.admits(ordinal)) results.add(snapshot.table[ordinal])
+                    if (results.size == limit) return results
+                }
+                if (node.top.size == node.postingCount) return results
+            }
+            
+            return materialize(frames.lastIndex).asSequence()
+                .filter { mask.admits(it) }
+                .take(limit)
+                .map { snapshot.table[it] }
+                .toList()
+        }
+        
+        /**
+         * Every result passing [filter] for the current query, best-ranked first.
+         * 
+         * Time: O(r log m) narrowed from the previous query's r results,
+         *       O(m log m) if no shorter query was materialized
+         */
+        fun allResults(filter: SnackSearchFilter = SnackSearchFilter.DEFAULT): List<Snack> {
+            refresh()
+            if (typed.isBlank()) return emptyList()
+            val mask = snapshot.flags.mask(filter)
+            return materialize(frames.lastIndex)
+                .filter { mask.admits(it) }
+                .map { snapshot.table[it] }
+        }
+        
+        private fun advance(frame: SessionFrame, c: Char): SessionFrame {
+            val node = frame.node ?: return SessionFrame(null, 0)
+            
+            if (frame.labelOffset < node.label.length) {
+                return if (node.label[frame.labelOffset] == c) {
+                    SessionFrame(node, frame.labelOffset + 1)
+                } else SessionFrame(null, 0)
+            }
+            
+            val slot = node.childIndex(c)
+            return if (slot < 0) SessionFrame(null, 0) else SessionFrame(node.children[slot], 1)
+        }
+        
+        private fun materialize(index: Int): IntArray {
+            val frame = frames[index]
+            frame.ranked?.let { return it }
+            val node = frame.node ?: return RadixNode.NO_POSTINGS
+            
+            val parent = frames.getOrNull(index - 1)
+            val inherited = parent?.ranked
+            val ranked = when {
+                parent?.node === node -> materialize(index - 1)
+                inherited != null -> narrow(inherited, node)
+                else -> snapshot.rankedPostings(node)
+            }
+            frame.ranked = ranked
+            return ranked
+        }
+        
+        private fun narrow(ranked: IntArray, node: RadixNode): IntArray {
+            val kept = IntArray(minOf(ranked.size, node.postingCount))
+            var size = 0
+            for (ordinal in ranked) {
+                if (size == kept.size) break
+                if (node.hasPosting(ordinal)) kept[size++] = ordinal
+            }
+            return kept.copyOf(size)
+        }
+        
+        private fun refresh() {
+            val latest = published.value
+            if (latest === snapshot) return
+            
+            val sameTrie = latest.generation == snapshot.generation
+            snapshot = latest
+            if (sameTrie) return
+            
+            frames.clear()
+            frames.add(rootFrame(latest))
+            for (c in typed) frames.add(advance(frames.last(), c))
+        }
+    }
+    
+    private fun rootFrame(snapshot: Snapshot) =
+        SessionFrame(snapshot.root, snapshot.root.label.length)
+    
+    // A null mask admits everything
+    private fun LongArray?.admits(ordinal: Int): Boolean {
+        if (this == null) return true
+        val word = ordinal ushr 6
+        return word < size && (this[word] and (1L shl ordinal)) != 0L
+    }
+    
+    // ==========================================
+    // PERSISTENCE
+    // ==========================================
+    
+    /**
+     * Serialize the current version for a cold start.
+     * 
+     * Format (big-endian):
+     * - magic, format version, topK
+     * - snack table: slot count, then a presence byte and fields per slot
+     * - total postings, then nodes in preorder: label, terminals, top list,
+     *   postings, query count, child count
+     * - CRC-32 of everything before it
+     * 
+     * Top lists are stored as ranked when written.
+     * 
+     * Time: O(n + w + P)
+     */
+    fun writeBinary(): ByteArray {
+        val snapshot = published.value
+        val sink = ByteSink()
+        sink.writeInt(BINARY_MAGIC)
+        sink.writeInt(BINARY_VERSION)
+        sink.writeInt(topK)
+        
+        val slots = snapshot.table.capacity
+        sink.writeInt(slots)
+        for (ordinal in 0 until slots) {
+            val snack = snapshot.table.getOrNull(ordinal)
+            sink.writeBoolean(snack != null)
+            if (snack != null) writeSnack(sink, snack)
+        }
+        
+        sink.writeInt(countPostings(snapshot.root))
+        writeNode(sink, snapshot.root)
+        
+        sink.writeInt(Crc32.compute(sink.toByteArray()))
+        return sink.toByteArray()
+    }
+    
+    /**
+     * Replace the index with one produced by [writeBinary], e.g. read in
+     * one go from disk at launch. The bytes are checksummed and fully
+     * decoded before anything is published; on a bad checksum, an unknown
+     * version or malformed data the index is left untouched.
+     * 
+     * Postings are decoded into one shared pool, as in [build]. Completion
+     * weights are recomputed, and top lists too if the snapshot was written
+     * with a different topK.
+     * 
+     * Time: O(n + w + P)
+     */
+    fun restoreBinary(bytes: ByteArray): Boolean {
+        if (bytes.size < BINARY_HEADER_SIZE + 4) return false
+        
+        val checksumAt = bytes.size - 4
+        val checksum = ByteSource(bytes.copyOfRange(checksumAt, bytes.size)).readInt()
+        if (checksum != Crc32.compute(bytes, 0, checksumAt)) return false
+        
+        val source = ByteSource(bytes, checksumAt)
+        return try {
+            if (source.readInt() != BINARY_MAGIC || source.readInt() != BINARY_VERSION) return false
+            val storedTopK = source.readInt()
+            
+            val slots = arrayOfNulls<Snack>(source.readLength(1))
+            for (ordinal in slots.indices) {
+                if (source.readBoolean()) slots[ordinal] = readSnack(source)
+            }
+            val root = NodeDecoder(source, source.readLength(4)).read()
+            
+            write { adopt(slots, root, reranked = storedTopK != topK) }
+            true
+        } catch (e: Exception) {
+            false
+        }
+    }
+    
+    private fun countPostings(node: RadixNode): Int =
+        node.postingCount + node.children.sumOf { countPostings(it) }
+    
+    private fun writeNode(sink: ByteSink, node: RadixNode) {
+        sink.writeString(node.label)
+        sink.writeInts(node.terminals)
+        sink.writeInts(node.top)
+        sink.writeInts(node.postings, node.postingFrom, node.postingFrom + node.postingCount)
+        sink.writeInt(node.queryCount)
+        sink.writeInt(node.children.size)
+        node.children.forEach { writeNode(sink, it) }
+    }
+    
+    private class NodeDecoder(private val source: ByteSource, poolSize: Int) {
+        private val pool = IntArray(poolSize)
+        private var poolEnd = 0
+        
+        fun read(): RadixNode {
+            val label = source.readString()
+            val terminals = source.readInts()
+            val top = source.readInts()
+            
+            val postingFrom = poolEnd
+            val postingCount = source.readLength(4)
+            require(postingFrom + postingCount <= pool.size) { "Posting pool overflow" }
+            repeat(postingCount) { pool[poolEnd++] = source.readInt() }
+            val queryCount = source.readInt()
+            
+            val children = Array(source.readLength(1)) { read() }
+            val keys = CharArray(children.size) { children[it].label[0] }
+            return RadixNode(label, keys, children, pool, postingFrom, postingCount, terminals, top, queryCount)
+        }
+    }
+    
+    private fun writeSnack(sink: ByteSink, snack: Snack) {
+        sink.writeString(snack.id)
+        sink.writeString(snack.name)
+        sink.writeString(snack.description)
+        sink.writeLong(snack.price.toRawBits())
+        sink.writeString(snack.category.name)
+        sink.writeString(snack.imageUrl)
+        sink.writeBoolean(snack.isAvailable)
+        sink.writeInt(snack.stockQuantity)
+        sink.writeInt(snack.preparationTime)
+        sink.writeBoolean(snack.isVegetarian)
+        sink.writeInt(snack.tags.size)
+        snack.tags.forEach { sink.writeString(it) }
+        sink.writeLong(snack.createdAt)
+        sink.writeLong(snack.updatedAt)
+    }
+    
+    private fun readSnack(source: ByteSource): Snack {
+        val id = source.readString()
+        val name = source.readString()
+        val description = source.readString()
+        val price = Double.fromBits(source.readLong())
+        val categoryName = source.readString()
+        val imageUrl = source.readString()
+        val isAvailable = source.readBoolean()
+        val stockQuantity = source.readInt()
+        val preparationTime = source.readInt()
+        val isVegetarian = source.readBoolean()
+        val tags = List(source.readLength(4)) { source.readString() }
+        return Snack(
+            id = id,
+            name = name,
+            description = description,
+            price = price,
+            category = SnackCategory.values().firstOrNull { it.name == categoryName } ?: SnackCategory.OTHER,
+            imageUrl = imageUrl,
+            isAvailable = isAvailable,
+            stockQuantity = stockQuantity,
+            preparationTime = preparationTime,
+            isVegetarian = isVegetarian,
+            tags = tags,
+            createdAt = source.readLong(),
+            updatedAt = source.readLong()
+        )
+    }
+    
+    // ==========================================
+    // WRITES
+    // ==========================================
+    
+    private inline fun <T> write(block: Mutation.() -> T): T = synchronized(writeLock) {
+        val mutation = Mutation(published.value)
+        mutation.countPendingSelections()
+        val result = mutation.block()
+        published.value = mutation.toSnapshot()
+        result
+    }
+    
+    /**
+     * Working copy of the latest snapshot. Every change path-copies from
+     * the root, so the published version is untouched until [write] swaps it.
+     */
+    private inner class Mutation(private val base: Snapshot) {
+        var root = base.root
+        var table = base.table
+        var flags = base.flags
+        var phonetics = base.phonetics
+        var ranking = base.ranking
+        
+        // Root as of the last structural change; counts alone advance it
+        private var countedRoot = base.root
+        
+        // Flag-only and count-only writes keep the generation, so sessions stay valid
+        fun toSnapshot(): Snapshot {
+            val trieChanged = root !== countedRoot || ranking !== base.ranking
+            val generation = if (trieChanged) base.generation + 1 else base.generation
+            val weightsChanged = root !== base.root || ranking !== base.ranking
+            val weights = if (weightsChanged) base.weights + 1 else base.weights
+            return Snapshot(root, table, flags, phonetics, ranking, ordinalById.size, generation, weights)
+        }
+        
+        fun countPendingSelections() {
+            pendingSelections.forEach { selection ->
+                indexedWords(selection.snack)
+                    .filter { word -> selection.terms.any { word.startsWith(it) } }
+                    .forEach { countQuery(it) }
+            }
+            pendingSelections.clear()
+        }
+        
+        fun insertSnack(snack: Snack) {
+            val existing = ordinalById[snack.id]
+            if (existing != null) {
+                updateSnack(table[existing], snack)
+                return
+            }
+            
+            val ordinal = allocateOrdinal(snack)
+            flags = flags.set(ordinal, snack)
+            val words = indexedWords(snack)
+            words.forEach { word -> insertWord(word, ordinal, reranked = false) }
+            phoneticKeys(words).forEach { key -> phonetics = phonetics.add(key, ordinal) }
+        }
+        
+        fun removeSnack(snackId: String): Boolean {
+            val ordinal = ordinalById.remove(snackId) ?: return false
+            
+            val words = indexedWords(table[ordinal])
+            words.forEach { word ->
+                root = removeWord(root, word, 0, ordinal)
+            }
+            phoneticKeys(words).forEach { key -> phonetics = phonetics.remove(key, ordinal) }
+            table = table.set(ordinal, null)
+            flags = flags.set(ordinal, null)
+            freeOrdinals.add(ordinal)
+            return true
+        }
+        
+        fun updateSnack(old: Snack, new: Snack) {
+            val ordinal = ordinalById[old.id]
+            if (ordinal == null || old.id != new.id) {
+                removeSnack(old.id)
+                insertSnack(new)
+                return
+            }
+            
+            val indexed = table[ordinal]
+            if (isFlagOnlyChange(indexed, new)) {
+                updateFlags(ordinal, new)
+                return
+            }
+            
+            // Diff against what was actually indexed, not what the caller remembers
+            val oldWords = indexedWords(indexed)
+            val newWords = indexedWords(new)
+            
+            // Stripping an old word also strips prefixes it shares with kept
+            // words; re-inserting the new words restores those postings
+            oldWords.forEach { word ->
+                if (word !in newWords) root = removeWord(root, word, 0, ordinal)
+            }
+            updateFlags(ordinal, new)
+            newWords.forEach { word -> insertWord(word, ordinal, reranked = true) }
+            
+            val oldKeys = phoneticKeys(oldWords)
+            val newKeys = phoneticKeys(newWords)
+            (oldKeys - newKeys).forEach { key -> phonetics = phonetics.remove(key, ordinal) }
+            (newKeys - oldKeys).forEach { key -> phonetics = phonetics.add(key, ordinal) }
+        }
+        
+        fun updateFlags(ordinal: Int, snack: Snack) {
+            table = table.set(ordinal, snack)
+            flags = flags.set(ordinal, snack)
+        }
+        
+        fun allocateOrdinal(snack: Snack): Int {
+            val ordinal = if (freeOrdinals.isNotEmpty()) {
+                freeOrdinals.removeAt(freeOrdinals.size - 1)
+            } else {
+                nextOrdinal++
+            }
+            table = table.set(ordinal, snack)
+            ordinalById[snack.id] = ordinal
+            return ordinal
+        }
+        
+        fun insertWord(word: String, ordinal: Int, reranked: Boolean) {
+            root = insertWord(root, word, 0, ordinal, reranked)
+        }
+        
+        // `node`'s own label is already matched; word[offset..] remains below it
+        private fun insertWord(
+            node: RadixNode,
+            word: String,
+            offset: Int,
+            ordinal: Int,
+            reranked: Boolean
+        ): RadixNode {
+            if (offset == word.length) {
+                return weigh(node.copy(terminals = PostingLists.insert(node.terminals, ordinal)))
+            }
+            
+            val slot = node.childIndex(word[offset])
+            if (slot < 0) {
+                // No edge starts with this char: hang the whole remainder as one leaf
+                val single = intArrayOf(ordinal)
+                val leaf = RadixNode(
+                    label = word.substring(offset),
+                    postings = single,
+                    postingCount = 1,
+                    terminals = single,
+                    top = single
+                )
+                return node.withNewChild(-(slot + 1), weigh(leaf))
+            }
+            
+            var child = node.children[slot]
+            val common = commonPrefixLength(child.label, word, offset)
+            if (common < child.label.length) {
+                child = child.split(common)
+            }
+            
+            val updated = insertWord(child, word, offset + common, ordinal, reranked)
+            return node.withChild(slot, addRankedPosting(updated, ordinal, reranked))
+        }
+        
+        // Add snack at each prefix node for prefix matching
+        private fun addRankedPosting(node: RadixNode, ordinal: Int, reranked: Boolean): RadixNode {
+            if (!node.hasPosting(ordinal)) {
+                val added = node.withPosting(ordinal)
+                return added.copy(top = offerTop(added.top, ordinal))
+            }
+            if (!reranked) return node
+            
+            // A replaced snack may have moved; if it was cached it may also
+            // have dropped below snacks that are not
+            return if (ordinal in node.top) {
+                node.copy(top = recomputeTop(node))
+            } else {
+                node.copy(top = offerTop(node.top, ordinal))
+            }
+        }
+        
+        private fun removeWord(node: RadixNode, word: String, offset: Int, ordinal: Int): RadixNode {
+            if (offset == word.length) {
+                return weigh(node.copy(terminals = PostingLists.remove(node.terminals, ordinal)))
+            }
+            
+            val slot = node.childIndex(word[offset])
+            if (slot < 0) return node
+            
+            val child = node.children[slot]
+            val common = commonPrefixLength(child.label, word, offset)
+            if (common < child.label.length) return node
+            
+            val updated = dropPosting(removeWord(child, word, offset + common, ordinal), ordinal)
+            return when {
+                updated.postingCount == 0 -> node.withoutChild(slot)
+                updated.children.size == 1 && !updated.isEndOfWord ->
+                    node.withChild(slot, updated.mergeWithOnlyChild())
+                else -> node.withChild(slot, updated)
+            }
+        }
+        
+        /**
+         * Removing from a top list keeps it a valid prefix of the ranking, just
+         * shorter; pages past it fall through to the ranked tail. It is refilled
+         * once it drops below half capacity, so refills amortize over K/2 removals.
+         */
+        private fun dropPosting(node: RadixNode, ordinal: Int): RadixNode {
+            if (!node.hasPosting(ordinal)) return node
+            val removed = node.withoutPosting(ordinal)
+            
+            val at = removed.top.indexOf(ordinal)
+            if (at < 0) return removed
+            
+            val top = removed.top.copyOfRange(0, at) + removed.top.copyOfRange(at + 1, removed.top.size)
+            return if (top.size < topK / 2 && removed.postingCount > top.size) {
+                removed.copy(top = recomputeTop(removed))
+            } else {
+                removed.copy(top = top)
+            }
+        }
         
-        // Insert by tags for better searchability
-        snack.tags.forEach { tag ->
-            insertWord(tag.lowercase(), snack)
+        fun rerank(node: RadixNode): RadixNode = node.copy(
+            children = Array(node.children.size) { rerank(node.children[it]) },
+            top = recomputeTop(node),
+            weight = wordWeight(node)
+        )
+        
+        /**
+         * Recompute completion weights of a whole subtree, e.g. after a bulk
+         * load or restore.
+         * Time: O(w + total terminals)
+         */
+        fun reweigh(node: RadixNode): RadixNode = node.copy(
+            children = Array(node.children.size) { reweigh(node.children[it]) },
+            weight = wordWeight(node)
+        )
+        
+        private fun weigh(node: RadixNode): RadixNode = node.copy(weight = wordWeight(node))
+        
+        // Query hits plus units sold of every snack indexed under the word
+        private fun wordWeight(node: RadixNode): Int {
+            if (!node.isEndOfWord) return 0
+            val sales = ranking as? SnackRanking ?: return node.queryCount
+            return node.queryCount + node.terminals.sumOf { sales.unitsSold(table[it].id) }
         }
         
-        // Insert by category
-        insertWord(snack.category.name.lowercase(), snack)
+        fun countQuery(word: String, hits: Int = 1) {
+            val counted = countQuery(root, word, 0, hits) ?: return
+            if (root === countedRoot) countedRoot = counted
+            root = counted
+        }
         
-        size++
-    }
-    
-    private fun insertWord(word: String, snack: Snack) {
-        var current = root
+        // Null if the word is not indexed; nothing is copied then
+        private fun countQuery(node: RadixNode, word: String, offset: Int, hits: Int): RadixNode? {
+            if (offset == word.length) {
+                return if (node.isEndOfWord) weigh(node.copy(queryCount = node.queryCount + hits)) else null
+            }
+            
+            val slot = node.childIndex(word[offset])
+            if (slot < 0) return null
+            
+            val child = node.children[slot]
+            val common = commonPrefixLength(child.label, word, offset)
+            if (common < child.label.length) return null
+            
+            return countQuery(child, word, offset + common, hits)?.let { node.withChild(slot, it) }
+        }
+        
+        /**
+         * Copy of a bounded top list with [ordinal] offered to it.
+         * Time: O(K)
+         */
+        private fun offerTop(top: IntArray, ordinal: Int): IntArray {
+            if (top.size == topK && compare(ordinal, top[topK - 1]) >= 0) return top
+            
+            var at = 0
+            while (at < top.size && compare(top[at], ordinal) < 0) at++
+            
+            val next = IntArray(minOf(top.size + 1, topK))
+            top.copyInto(next, 0, 0, at)
+            next[at] = ordinal
+            top.copyInto(next, at + 1, at, next.size - 1)
+            return next
+        }
+        
+        /**
+         * Time: O(m K)
+         */
+        private fun recomputeTop(node: RadixNode): IntArray {
+            var top = RadixNode.NO_POSTINGS
+            for (i in node.postingFrom until node.postingFrom + node.postingCount) {
+                top = offerTop(top, node.postings[i])
+            }
+            return top
+        }
+        
+        private fun compare(a: Int, b: Int): Int = table.compare(ranking, a, b)
         
-        for (char in word) {
-            current = current.children.getOrPut(char) { TrieNode() }
-            // Add snack at each prefix node for prefix matching
-            if (!current.snacks.contains(snack)) {
-                current.snacks.add(snack)
+        /**
+         * Take over a decoded binary snapshot. See [restoreBinary].
+         */
+        fun adopt(slots: Array<Snack?>, decodedRoot: RadixNode, reranked: Boolean) {
+            ordinalById.clear()
+            freeOrdinals.clear()
+            nextOrdinal = slots.size
+            
+            slots.forEachIndexed { ordinal, snack ->
+                if (snack == null) freeOrdinals.add(ordinal) else ordinalById[snack.id] = ordinal
+            }
+            table = SnackTable.of(slots)
+            flags = SnackFlags.of(slots.size) { slots[it] }
+            // Not persisted; keys are cheap to derive from the restored words
+            phonetics = PhoneticIndex.of(slots.size) { ordinal ->
+                slots[ordinal]?.let { phoneticKeys(indexedWords(it)) } ?: emptySet()
             }
+            root = if (reranked) rerank(decodedRoot) else reweigh(decodedRoot)
         }
         
-        current.isEndOfWord = true
+        /**
+         * [bulkLoad] that keeps the query hits of words still indexed
+         * afterwards, for syncing an index that is already in use.
+         * Time: O(E log E + P log K + h k) where h is words with hits
+         */
+        fun reload(snacks: Collection<Snack>) {
+            val hits = HashMap<String, Int>()
+            collectQueryCounts(root, "", hits)
+            bulkLoad(snacks.toList())
+            hits.forEach { (word, count) -> countQuery(word, count) }
+        }
+        
+        private fun collectQueryCounts(node: RadixNode, prefix: String, hits: MutableMap<String, Int>) {
+            val word = prefix + node.label
+            if (node.isEndOfWord && node.queryCount > 0) hits[word] = node.queryCount
+            node.children.forEach { collectQueryCounts(it, word, hits) }
+        }
+        
+        /**
+         * Replace the whole index from a catalog snapshot. See [build].
+         */
+        fun bulkLoad(snacks: List<Snack>) {
+            ordinalById.clear()
+            freeOrdinals.clear()
+            nextOrdinal = 0
+            table = SnackTable.EMPTY
+            
+            snacks.forEach { snack ->
+                val ordinal = ordinalById[snack.id]
+                if (ordinal != null) {
+                    table = table.set(ordinal, snack)
+                } else {
+                    allocateOrdinal(snack)
+                }
+            }
+            
+            val entries = ArrayList<IndexedWord>(nextOrdinal * 4)
+            for (ordinal in 0 until nextOrdinal) {
+                indexedWords(table[ordinal]).forEach { word -> entries.add(IndexedWord(word, ordinal)) }
+            }
+            entries.sortBy { it.word }
+            
+            // Global rank positions turn per-node top-K selection into Int compares
+            val rank = IntArray(nextOrdinal)
+            (0 until nextOrdinal).sortedWith(Comparator { a, b -> compare(a, b) }).forEachIndexed { position, ordinal ->
+                rank[ordinal] = position
+            }
+            
+            flags = SnackFlags.of(nextOrdinal) { table[it] }
+            phonetics = PhoneticIndex.of(nextOrdinal) { phoneticKeys(indexedWords(table[it])) }
+            root = reweigh(BulkLoader(entries, rank, topK).load())
+        }
     }
     
+    // Availability and stock are neither indexed nor ranked
+    private fun isFlagOnlyChange(indexed: Snack, new: Snack): Boolean =
+        indexed.copy(
+            isAvailable = new.isAvailable,
+            stockQuantity = new.stockQuantity,
+            updatedAt = new.updatedAt
+        ) == new
+    
     /**
-     * Search for snacks by prefix.
-     * Returns all snacks whose name/tag starts with the prefix.
-     * 
-     * Time: O(k + m) where k is prefix length, m is results
+     * Distinct words a snack is indexed under: name, tags and category,
+     * folded once here so queries only need the same fold. Multi-word
+     * names and tags are indexed whole and per word, so both "masala m" and
+     * "masala" reach "Maggi Masala"; synonyms of each are indexed too.
      */
-    fun search(prefix: String): List<Snack> {
-        if (prefix.isBlank()) return emptyList()
+    private fun indexedWords(snack: Snack): Set<String> {
+        val words = LinkedHashSet<String>()
         
-        var current = root
-        val lowerPrefix = prefix.lowercase()
+        // Index by name
+        addTextWords(snack.name, words)
         
-        // Navigate to prefix end node
-        for (char in lowerPrefix) {
-            current = current.children[char] ?: return emptyList()
+        // Index by tags for better searchability
+        snack.tags.forEach { tag -> addTextWords(tag, words) }
+        
+        // Index by category
+        addTextWords(snack.category.name, words)
+        
+        words.remove("")
+        return words
+    }
+    
+    /**
+     * Distinct [SnackPhonetics] keys of the single words in [words].
+     */
+    private fun phoneticKeys(words: Set<String>): Set<Long> {
+        val keys = HashSet<Long>()
+        for (word in words) {
+            if (' ' in word) continue
+            val key = SnackPhonetics.key(word)
+            if (key != 0L) keys.add(key)
         }
+        return keys
+    }
+    
+    private fun addTextWords(text: String, words: MutableSet<String>) {
+        val folded = SnackTextNormalizer.fold(text)
+        addPhrase(folded, words)
         
-        // Return all snacks at this node (includes all with this prefix)
-        return current.snacks
-            .filter { it.isAvailable }
-            .distinctBy { it.id }
-            .sortedBy { it.name }
+        val parts = folded.split(' ')
+        if (parts.size > 1) parts.forEach { addPhrase(it, words) }
     }
     
+    private fun addPhrase(phrase: String, words: MutableSet<String>) {
+        words.add(phrase)
+        for (synonym in SnackTextNormalizer.synonymsOf(phrase)) {
+            words.add(synonym)
+            if (' ' in synonym) words.addAll(synonym.split(' '))
+        }
+    }
+    
+    // ==========================================
+    // BULK LOAD
+    // ==========================================
+    
+    private class IndexedWord(val word: String, val ordinal: Int)
+    
     /**
-     * Get autocomplete suggestions.
-     * Returns word completions for the given prefix.
-     * 
-     * Time: O(k + n) where n is number of words with prefix
+     * One-pass radix construction over a sorted word run.
+     * Nodes are drafted first and frozen once the shared pool is final.
      */
-    fun getSuggestions(prefix: String, limit: Int = 10): List<String> {
-        if (prefix.isBlank()) return emptyList()
+    private class BulkLoader(
+        private val entries: List<IndexedWord>,
+        private val rank: IntArray,
+        private val topK: Int
+    ) {
+        private class Draft(
+            val label: String,
+            val postingFrom: Int,
+            val postingCount: Int,
+            val terminals: IntArray,
+            val top: IntArray,
+            val children: List<Draft>
+        )
         
-        var current = root
-        val lowerPrefix = prefix.lowercase()
+        // stamps[ordinal] == id of the last node that already took this ordinal
+        private val stamps = IntArray(rank.size) { -1 }
+        private val best = IntArray(topK)
+        private var pool = IntArray(maxOf(16, entries.size * 2))
+        private var poolSize = 0
+        private var nodeCount = 0
         
-        for (char in lowerPrefix) {
-            current = current.children[char] ?: return emptyList()
+        fun load(): RadixNode {
+            val children = if (entries.isEmpty()) emptyList() else draftChildren(0, entries.size, 0)
+            
+            // Every node shares one trimmed pool
+            val finalPool = pool.copyOf(poolSize)
+            return RadixNode(
+                label = "",
+                keys = CharArray(children.size) { children[it].label[0] },
+                children = Array(children.size) { freeze(children[it], finalPool) }
+            )
         }
         
-        val suggestions = mutableListOf<String>()
-        collectWords(current, StringBuilder(lowerPrefix), suggestions, limit)
-        return suggestions
+        private fun freeze(draft: Draft, finalPool: IntArray): RadixNode = RadixNode(
+            label = draft.label,
+            keys = CharArray(draft.children.size) { draft.children[it].label[0] },
+            children = Array(draft.children.size) { freeze(draft.children[it], finalPool) },
+            postings = finalPool,
+            postingFrom = draft.postingFrom,
+            postingCount = draft.postingCount,
+            terminals = draft.terminals,
+            top = draft.top
+        )
+        
+        // entries[low until high] share their first `depth` chars and are all longer than that
+        private fun draftChildren(low: Int, high: Int, depth: Int): List<Draft> {
+            val children = ArrayList<Draft>()
+            var start = low
+            
+            while (start < high) {
+                val key = entries[start].word[depth]
+                var end = start + 1
+                while (end < high && entries[end].word[depth] == key) end++
+                children.add(draftNode(start, end, depth))
+                start = end
+            }
+            return children
+        }
+        
+        private fun draftNode(low: Int, high: Int, depth: Int): Draft {
+            // In a sorted run the LCP of first and last word is the LCP of the whole range
+            val first = entries[low].word
+            val last = entries[high - 1].word
+            val max = minOf(first.length, last.length)
+            var end = depth + 1
+            while (end < max && first[end] == last[end]) end++
+            
+            val postingFrom = poolSize
+            collectPostings(low, high)
+            val top = selectTop(postingFrom, poolSize)
+            
+            // Words ending exactly here sort before their extensions
+            var childLow = low
+            while (childLow < high && entries[childLow].word.length == end) childLow++
+            val terminals = if (childLow > low) {
+                IntArray(childLow - low) { entries[low + it].ordinal }
+                    .also { it.sort() }
+                    .distinct()
+                    .toIntArray()
+            } else RadixNode.NO_POSTINGS
+            
+            return Draft(
+                label = first.substring(depth, end),
+                postingFrom = postingFrom,
+                postingCount = poolSize - postingFrom,
+                terminals = terminals,
+                top = top,
+                children = if (childLow < high) draftChildren(childLow, high, end) else emptyList()
+            )
+        }
+        
+        private fun collectPostings(low: Int, high: Int) {
+            val id = nodeCount++
+            val from = poolSize
+            for (i in low until high) {
+                val ordinal = entries[i].ordinal
+                if (stamps[ordinal] == id) continue
+                stamps[ordinal] = id
+                
+                if (poolSize == pool.size) pool = pool.copyOf(pool.size * 2)
+                pool[poolSize++] = ordinal
+            }
+            pool.sort(from, poolSize)
+        }
+        
+        // Bounded insertion into `best`, ordered by global rank
+        private fun selectTop(from: Int, to: Int): IntArray {
+            var size = 0
+            for (i in from until to) {
+                val ordinal = pool[i]
+                if (size == topK && rank[ordinal] >= rank[best[size - 1]]) continue
+                
+                var at = if (size < topK) size++ else size - 1
+                while (at > 0 && rank[best[at - 1]] > rank[ordinal]) {
+                    best[at] = best[at - 1]
+                    at--
+                }
+                best[at] = ordinal
+            }
+            return best.copyOf(size)
+        }
     }
     
-    private fun collectWords(
-        node: TrieNode,
-        currentWord: StringBuilder,
-        results: MutableList<String>,
-        limit: Int
-    ) {
-        if (results.size >= limit) return
+    companion object {
+        
+        const val DEFAULT_TOP_K = 20
+        
+        private const val SUGGESTION_CACHE_SIZE = 64
+        
+        // Picks buffered before they are counted into the trie
+        const val SELECTION_BATCH = 16
+        
+        // Snapshot diffs restructuring more than 1/4 of the catalog are bulk-loaded
+        private const val BULK_SYNC_DIVISOR = 4
+        
+        // "HDST"
+        private const val BINARY_MAGIC = 0x48445354
+        // Bumped whenever indexed words or node fields change
+        private const val BINARY_VERSION = 3
+        private const val BINARY_HEADER_SIZE = 12
+        
+        private const val NAME_FIELD_SCORE = 3
+        private const val TAG_FIELD_SCORE = 2
+        private const val CATEGORY_FIELD_SCORE = 1
+        
+        /**
+         * The folded form queries are matched in ("Café-Latte" -> "cafe latte").
+         */
+        fun normalize(query: String): String = SnackTextNormalizer.fold(query)
+        
+        /**
+         * Split a query into distinct folded terms.
+         */
+        fun parseTerms(query: String): List<String> =
+            SnackTextNormalizer.fold(query).split(' ').filter { it.isNotEmpty() }.distinct()
+        
+        /**
+         * Edits allowed for a query of [length] chars: none for very short
+         * queries, one for typical words, two for long ones.
+         */
+        fun fuzzyEditBudget(length: Int): Int = when {
+            length < 3 -> 0
+            length < 6 -> 1
+            else -> 2
+        }
         
-        if (node.isEndOfWord) {
-            results.add(currentWord.toString())
+        /**
+         * Bulk-load a trie from a full catalog snapshot.
+         * 
+         * Indexed words are sorted once, then nodes are emitted in a single
+         * pass over the sorted run: a node's label is the longest common prefix
+         * of the first and last word in its range, and its postings are the
+         * distinct ordinals of that range, deduplicated with an O(1) stamp check
+         * and written into one shared posting pool.
+         * 
+         * Time: O(E log E + P log K) where E is indexed words, P is total postings
+         */
+        fun build(
+            snacks: List<Snack>,
+            ranking: Comparator<Snack> = SnackRanking(),
+            topK: Int = DEFAULT_TOP_K
+        ): SnackSearchTrie {
+            val trie = SnackSearchTrie(ranking, topK)
+            trie.write { bulkLoad(snacks) }
+            return trie
         }
+    }
+}
+
+/**
+ * Default search ranking: most ordered first, then name.
+ * Availability and stock are search filters, not ranking keys, so flipping
+ * them never reorders cached results.
+ */
+class SnackRanking(
+    private val popularity: Map<String, Int> = emptyMap()
+) : Comparator<Snack> {
+    
+    override fun compare(a: Snack, b: Snack): Int {
+        val byPopularity = (popularity[b.id] ?: 0).compareTo(popularity[a.id] ?: 0)
+        if (byPopularity != 0) return byPopularity
         
-        for ((char, child) in node.children) {
-            currentWord.append(char)
-            collectWords(child, currentWord, results, limit)
-            currentWord.deleteAt(currentWord.length - 1)
+        return a.name.compareTo(b.name)
+    }
+    
+    fun unitsSold(snackId: String): Int = popularity[snackId] ?: 0
+    
+    // Equal sales rank equally, so indexes can skip re-ranking
+    override fun equals(other: Any?): Boolean = other is SnackRanking && other.popularity == popularity
+    
+    override fun hashCode(): Int = popularity.hashCode()
+    
+    companion object {
+        
+        /**
+         * Popularity from delivered order history (units sold per snack).
+         * Time: O(total order items)
+         */
+        fun fromOrders(orders: List<SnackOrder>): SnackRanking {
+            val unitsSold = mutableMapOf<String, Int>()
+            orders
+                .filter { it.status == OrderStatus.DELIVERED }
+                .forEach { order ->
+                    order.items.forEach { item ->
+                        unitsSold[item.snackId] = (unitsSold[item.snackId] ?: 0) + item.quantity
+                    }
+                }
+            return SnackRanking(unitsSold)
+        }
+    }
+}
+
+/**
+ * Flag filters for search results. Unavailable snacks are hidden unless
+ * [includeUnavailable] is set.
+ */
+data class SnackSearchFilter(
+    val includeUnavailable: Boolean = false,
+    val vegetarianOnly: Boolean = false,
+    val inStockOnly: Boolean = false
+) {
+    
+    /**
+     * Check one snack directly, for indexes that keep no flag bitsets.
+     */
+    fun admits(snack: Snack): Boolean =
+        (includeUnavailable || snack.isAvailable) &&
+            (!vegetarianOnly || snack.isVegetarian) &&
+            (!inStockOnly || snack.stockQuantity > 0)
+    
+    companion object {
+        val DEFAULT = SnackSearchFilter()
+    }
+}
+
+/**
+ * Helpers for sorted, distinct IntArray posting ranges.
+ */
+internal object PostingLists {
+    
+    /**
+     * Binary search over `array[from until to]`.
+     * Returns the index if found, otherwise -(insertionPoint + 1).
+     */
+    fun indexOf(array: IntArray, from: Int, to: Int, key: Int): Int {
+        var low = from
+        var high = to - 1
+        while (low <= high) {
+            val mid = (low + high) ushr 1
+            val value = array[mid]
+            when {
+                value < key -> low = mid + 1
+                value > key -> high = mid - 1
+                else -> return mid
+            }
         }
+        return -(low + 1)
     }
     
     /**
-     * Clear the trie.
-     * Time: O(1)
+     * Galloping search for [key] in `array[from until to]`, with the same
+     * result convention as [indexOf]. Probes from + 1, + 3, + 7, ... until it
+     * passes the key, then binary searches that span, so keys close to
+     * [from] are found in O(log distance).
      */
-    fun clear() {
-        root = TrieNode()
-        size = 0
+    fun gallop(array: IntArray, from: Int, to: Int, key: Int): Int {
+        var low = from
+        var step = 1
+        while (low + step < to && array[low + step] < key) {
+            low += step
+            step = step shl 1
+        }
+        return indexOf(array, low, minOf(low + step + 1, to), key)
+    }
+    
+    /**
+     * Sorted intersection of `a[aFrom until aTo]` and `b[bFrom until bTo]`.
+     * Walks the shorter range and gallops through the longer one, resuming
+     * each search where the previous one stopped.
+     * 
+     * Time: O(s log(l / s)) where s and l are the shorter and longer lengths
+     */
+    fun intersect(a: IntArray, aFrom: Int, aTo: Int, b: IntArray, bFrom: Int, bTo: Int): IntArray {
+        if (aTo - aFrom > bTo - bFrom) return intersect(b, bFrom, bTo, a, aFrom, aTo)
+        
+        val result = IntArray(aTo - aFrom)
+        var size = 0
+        var low = bFrom
+        for (i in aFrom until aTo) {
+            if (low >= bTo) break
+            val found = gallop(b, low, bTo, a[i])
+            if (found >= 0) {
+                result[size++] = a[i]
+                low = found + 1
+            } else {
+                low = -(found + 1)
+            }
+        }
+        return result.copyOf(size)
+    }
+    
+    /**
+     * Copy of a small sorted array with [key] added, or the same array if present.
+     */
+    fun insert(array: IntArray, key: Int): IntArray {
+        val position = indexOf(array, 0, array.size, key)
+        if (position >= 0) return array
+        val at = -(position + 1)
+        
+        val result = IntArray(array.size + 1)
+        array.copyInto(result, 0, 0, at)
+        result[at] = key
+        array.copyInto(result, at + 1, at, array.size)
+        return result
     }
     
-    fun getSize(): Int = size
+    /**
+     * Copy of a small sorted array with [key] removed, or the same array if absent.
+     */
+    fun remove(array: IntArray, key: Int): IntArray {
+        val at = indexOf(array, 0, array.size, key)
+        if (at < 0) return array
+        
+        val result = IntArray(array.size - 1)
+        array.copyInto(result, 0, 0, at)
+        array.copyInto(result, at, at + 1, array.size)
+        return result
+    }
 }
 
 // ==========================================
@@ -163,40 +2246,89 @@ class SnackSearchTrie {
  * - Sleep: 15% weight
  * - Personality: 10% weight
  * 
+ * Surveys are encoded once into a [SurveyFeatureMatrix] when added; edges
+ * are scored from its primitive columns, so no time string is parsed and
+ * no answer string compared per pair.
+ * 
+ * Top matches only consider candidates that pass both students'
+ * deal-breakers ([ConstraintIndex]), then run a branch-and-bound search:
+ * every candidate gets a cheap optimistic bound
+ * ([SurveyFeatureMatrix.upperBound]), candidates are visited best bound
+ * first (counting sort over 0..100), and the search
+ * stops once a bound falls below the K-th best exact score. Exact scores go
+ * through a K-slot min-heap; only the K survivors become
+ * [CompatibilityScore] objects, and nothing is cached, so memory stays
+ * O(n + K) per query.
+ * 
+ * Edges carry the `updatedAt` of both surveys and of the profile they
+ * were computed from. Replacing a student's survey with a newer version
+ * drops that student's cached edges and marks them dirty; [recomputeRow]
+ * rescores just that row, and [isCurrent] tells whether a stored score is
+ * still valid.
+ * 
+ * Points and weights come from [profile], compiled once into a
+ * [ScoringPlan].
+ * 
  * Time Complexity:
  * - Add student: O(1)
  * - Calculate edge: O(1)
- * - Get matches: O(n log n) due to sorting
+ * - Get matches: O(n) bounds plus O(m log K) for the m candidates scored
  * - Generate all: O(n²)
  */
-class CompatibilityGraph {
+class CompatibilityGraph(profile: ScoringProfile = ScoringProfile.DEFAULT) {
     
-    // Graph node representing a student with their survey
+    // Graph node representing a student with their survey and feature row
     private data class StudentNode(
         val studentId: String,
         val survey: RoommateSurvey,
+        val row: Int,
         val edges: MutableMap<String, CompatibilityScore> = mutableMapOf()
     )
     
     // Adjacency list representation
     private val students = mutableMapOf<String, StudentNode>()
     
-    // Scoring weights (total = 100%)
-    private object Weights {
-        const val LIFESTYLE = 0.20
-        const val STUDY = 0.20
-        const val CLEANLINESS = 0.20
-        const val SOCIAL = 0.15
-        const val SLEEP = 0.15
-        const val PERSONALITY = 0.10
-    }
+    private val features = SurveyFeatureMatrix(plan = ScoringPlan.of(profile))
+    
+    // Stamped on every edge; a saved profile invalidates older scores
+    private val profileVersion = profile.updatedAt
+    
+    // Highest overall score, for bucketing bounds
+    private val maxScore = features.plan.maxOverall
+    
+    // Student id of each feature row
+    private val rowIds = mutableListOf<String>()
+    
+    // Scratch for the six category scores of the edge being built
+    private val categories = IntArray(SurveyFeatureMatrix.CATEGORY_COUNT)
+    
+    // Students whose survey changed since their row was last recomputed
+    private val dirty = mutableSetOf<String>()
+    
+    // Deal-breaker index over the current rows, built on first use
+    private var constraintIndex: ConstraintIndex? = null
     
     /**
-     * Add a student to the graph.
-     * Time: O(1)
+     * Add a student to the graph, or replace their survey. A changed
+     * survey invalidates the student's cached edges and marks them dirty;
+     * an identical one is a no-op.
+     * Time: O(1), plus O(d) for d cached edges on replacement
      */
     fun addStudent(studentId: String, survey: RoommateSurvey) {
-        students[studentId] = StudentNode(studentId, survey)
+        val existing = students[studentId]
+        if (existing == null) {
+            constraintIndex = null
+            rowIds.add(studentId)
+            students[studentId] = StudentNode(studentId, survey, features.add(survey))
+            return
+        }
+        if (existing.survey.updatedAt == survey.updatedAt && existing.survey == survey) return
+        
+        features.set(existing.row, survey)
+        constraintIndex = null
+        existing.edges.keys.forEach { otherId -> students[otherId]?.edges?.remove(studentId) }
+        students[studentId] = StudentNode(studentId, survey, existing.row)
+        dirty.add(studentId)
     }
     
     /**
@@ -210,45 +2342,12 @@ class CompatibilityGraph {
         // Check cache first
         node1.edges[studentId2]?.let { return it }
         
-        // Calculate individual scores
-        val lifestyleScore = calculateLifestyleScore(node1.survey.lifestyle, node2.survey.lifestyle)
-        val studyScore = calculateStudyScore(node1.survey.studyHabits, node2.survey.studyHabits)
-        val cleanlinessScore = calculateCleanlinessScore(node1.survey.cleanliness, node2.survey.cleanliness)
-        val socialScore = calculateSocialScore(node1.survey.socialPreferences, node2.survey.socialPreferences)
-        val sleepScore = calculateSleepScore(node1.survey.sleepSchedule, node2.survey.sleepSchedule)
-        val personalityScore = calculatePersonalityScore(node1.survey.personalityTraits, node2.survey.personalityTraits)
-        
-        // Weighted overall score
-        val overallScore = (
-            lifestyleScore * Weights.LIFESTYLE +
-            studyScore * Weights.STUDY +
-            cleanlinessScore * Weights.CLEANLINESS +
-            socialScore * Weights.SOCIAL +
-            sleepScore * Weights.SLEEP +
-            personalityScore * Weights.PERSONALITY
-        ).toInt()
-        
-        // Generate match reasons and warnings
-        val matchReasons = generateMatchReasons(
-            lifestyleScore, studyScore, cleanlinessScore, 
-            socialScore, sleepScore, personalityScore
-        )
-        val warnings = generateWarnings(node1.survey, node2.survey)
+        val overallScore = features.score(node1.row, node2.row, categories)
         
-        val score = CompatibilityScore(
-            id = "${studentId1}_${studentId2}",
-            studentId1 = studentId1,
-            studentId2 = studentId2,
-            overallScore = overallScore,
-            lifestyleScore = lifestyleScore,
-            studyScore = studyScore,
-            cleanlinessScore = cleanlinessScore,
-            socialScore = socialScore,
-            sleepScore = sleepScore,
-            personalityScore = personalityScore,
-            matchReasons = matchReasons,
-            warnings = warnings,
-            calculatedAt = System.currentTimeMillis()
+        val score = buildScore(
+            studentId1, studentId2, overallScore, categories,
+            features.warnings(node1.row, node2.row),
+            node1.survey.updatedAt, node2.survey.updatedAt, profileVersion, System.currentTimeMillis()
         )
         
         // Cache the edge (bidirectional)
@@ -259,24 +2358,110 @@ class CompatibilityGraph {
     }
     
     /**
-     * Get top matches for a student.
-     * Time: O(n log n) due to sorting
+     * Whether neither student has a trait the other listed as a
+     * deal-breaker; false if either is missing. The batch engine and
+     * [recomputeRow] skip pairs that are not.
+     * Time: O(1)
+     */
+    fun isCompatible(studentId1: String, studentId2: String): Boolean {
+        val node1 = students[studentId1] ?: return false
+        val node2 = students[studentId2] ?: return false
+        return features.compatible(node1.row, node2.row)
+    }
+    
+    /**
+     * Get top matches for a student, best first; equal scores keep the
+     * order students were added in.
+     * Time: O(n + m log K) where m candidates survive the bound
      */
     fun getTopMatches(studentId: String, limit: Int = 10): List<CompatibilityScore> {
         val node = students[studentId] ?: return emptyList()
+        if (limit <= 0) return emptyList()
         
-        // Calculate edges with all other students if not already done
-        students.keys
-            .filter { it != studentId && !node.edges.containsKey(it) }
-            .forEach { otherId ->
-                calculateEdge(studentId, otherId)
-            }
+        // Deal-breakers drop candidates before any scoring
+        val candidates = constraints().candidates(node.row)
         
-        return node.edges.values
-            .sortedByDescending { it.overallScore }
-            .take(limit)
+        // Bound every candidate and bucket by bound
+        val bounds = IntArray(features.size)
+        val bucketStarts = IntArray(maxScore + 2)
+        for (row in candidates) {
+            bounds[row] = features.upperBound(node.row, row).coerceIn(0, maxScore)
+            bucketStarts[maxScore - bounds[row] + 1]++
+        }
+        for (i in 1 until bucketStarts.size) bucketStarts[i] += bucketStarts[i - 1]
+        
+        // Highest bound first, rows ascending within a bound
+        val order = IntArray(candidates.size)
+        for (row in candidates) {
+            order[bucketStarts[maxScore - bounds[row]]++] = row
+        }
+        
+        val top = TopMatches(minOf(limit, order.size))
+        for (row in order) {
+            // Bounds only fall from here, so nothing left can enter the top K
+            if (bounds[row] < top.threshold) break
+            top.offer(row, features.overallScore(node.row, row))
+        }
+        
+        // Full edges for the survivors only
+        val calculatedAt = System.currentTimeMillis()
+        return top.drain().map { row ->
+            val otherId = rowIds[row]
+            node.edges[otherId] ?: buildScore(
+                studentId, otherId, features.score(node.row, row, categories), categories,
+                features.warnings(node.row, row),
+                node.survey.updatedAt, versionOfRow(row), profileVersion, calculatedAt
+            )
+        }
+    }
+    
+    /**
+     * Rescore [studentId] against every student no deal-breaker rules out
+     * and clear their dirty mark, so the row holds the same pairs the batch
+     * engine persists. The row is returned, not cached.
+     * Time: O(c n / 64 + n)
+     */
+    fun recomputeRow(studentId: String): List<CompatibilityScore> {
+        val node = students[studentId] ?: return emptyList()
+        dirty.remove(studentId)
+        
+        val calculatedAt = System.currentTimeMillis()
+        val candidates = constraints().candidates(node.row)
+        val scores = ArrayList<CompatibilityScore>(candidates.size)
+        for (row in candidates) {
+            scores.add(
+                buildScore(
+                    studentId, rowIds[row], features.score(node.row, row, categories), categories,
+                    features.warnings(node.row, row),
+                    node.survey.updatedAt, versionOfRow(row), profileVersion, calculatedAt
+                )
+            )
+        }
+        return scores
+    }
+    
+    /**
+     * Students whose survey changed since their row was last recomputed.
+     */
+    fun dirtyStudents(): Set<String> = dirty.toSet()
+    
+    /**
+     * Whether [score] was computed from the surveys currently in the graph
+     * and with the graph's profile.
+     * Time: O(1)
+     */
+    fun isCurrent(score: CompatibilityScore): Boolean {
+        val survey1 = students[score.studentId1]?.survey ?: return false
+        val survey2 = students[score.studentId2]?.survey ?: return false
+        return score.profileVersion == profileVersion &&
+            score.survey1Version == survey1.updatedAt && score.survey2Version == survey2.updatedAt
     }
     
+    private fun versionOfRow(row: Int): Long = students.getValue(rowIds[row]).survey.updatedAt
+    
+    private fun constraints(): ConstraintIndex =
+        constraintIndex ?: ConstraintIndex(features).also { constraintIndex = it }
+    
     /**
      * Get all edges (compatibility scores) in the graph.
      * Time: O(n)
@@ -294,171 +2479,156 @@ class CompatibilityGraph {
      */
     fun clear() {
         students.clear()
+        rowIds.clear()
+        dirty.clear()
+        constraintIndex = null
+        features.clear()
     }
     
-    // ==========================================
-    // SCORING ALGORITHMS
-    // ==========================================
-    
-    private fun calculateLifestyleScore(l1: LifestylePreferences, l2: LifestylePreferences): Int {
-        var score = 0
-        
-        // Sleep time similarity (0-25 points)
-        val sleepDiff = kotlin.math.abs(parseTime(l1.sleepTime) - parseTime(l2.sleepTime))
-        score += maxOf(0, 25 - sleepDiff / 30) // Lose 1 point per 30 min difference
-        
-        // Wake time similarity (0-25 points)
-        val wakeDiff = kotlin.math.abs(parseTime(l1.wakeTime) - parseTime(l2.wakeTime))
-        score += maxOf(0, 25 - wakeDiff / 30)
-        
-        // Food preference (0-20 points)
-        score += if (l1.foodPreference == l2.foodPreference) 20 else 10
-        
-        // Smoking/Drinking habits (0-30 points)
-        if (l1.smokingHabit == l2.smokingHabit) score += 15
-        if (l1.drinkingHabit == l2.drinkingHabit) score += 15
-        
-        return score
-    }
-    
-    private fun calculateStudyScore(s1: StudyHabits, s2: StudyHabits): Int {
-        var score = 0
-        
-        // Study style match (0-30 points)
-        score += if (s1.studyStyle == s2.studyStyle) 30 else 15
-        
-        // Quiet environment needs (0-25 points)
-        score += if (s1.needsQuietEnvironment == s2.needsQuietEnvironment) 25 else 10
-        
-        // Study time preference (0-25 points)
-        score += if (s1.preferredStudyTime == s2.preferredStudyTime) 25 else 12
-        
-        // Music while studying (0-20 points)
-        score += if (s1.musicWhileStudying == s2.musicWhileStudying) 20 else 10
-        
-        return score
-    }
-    
-    private fun calculateCleanlinessScore(c1: CleanlinessPreferences, c2: CleanlinessPreferences): Int {
-        var score = 0
-        
-        // Cleaning frequency (0-35 points)
-        score += if (c1.cleaningFrequency == c2.cleaningFrequency) 35 else 17
-        
-        // Organization level similarity (0-35 points)
-        val orgDiff = kotlin.math.abs(c1.organizationLevel - c2.organizationLevel)
-        score += maxOf(0, 35 - orgDiff * 10)
-        
-        // Shared items comfort (0-30 points)
-        val sharedDiff = kotlin.math.abs(c1.sharedItemsComfort - c2.sharedItemsComfort)
-        score += maxOf(0, 30 - sharedDiff * 8)
-        
-        return score
-    }
-    
-    private fun calculateSocialScore(s1: SocialPreferences, s2: SocialPreferences): Int {
-        var score = 0
-        
-        // Visitor frequency (0-35 points)
-        score += if (s1.visitorFrequency == s2.visitorFrequency) 35 else 17
-        
-        // Party attitude (0-30 points)
-        score += if (s1.partyAttitude == s2.partyAttitude) 30 else 15
-        
-        // Privacy needs similarity (0-35 points)
-        val privacyDiff = kotlin.math.abs(s1.privacyNeeds - s2.privacyNeeds)
-        score += maxOf(0, 35 - privacyDiff * 10)
-        
-        return score
-    }
-    
-    private fun calculateSleepScore(s1: SleepSchedule, s2: SleepSchedule): Int {
-        var score = 0
-        
-        // Bedtime similarity (0-35 points)
-        val bedDiff = kotlin.math.abs(parseTime(s1.typicalBedtime) - parseTime(s2.typicalBedtime))
-        score += maxOf(0, 35 - bedDiff / 20)
-        
-        // Wake time similarity (0-35 points)
-        val wakeDiff = kotlin.math.abs(parseTime(s1.typicalWakeTime) - parseTime(s2.typicalWakeTime))
-        score += maxOf(0, 35 - wakeDiff / 20)
-        
-        // Sleep sensitivity (0-30 points)
-        score += if (s1.sleepSensitivity == s2.sleepSensitivity) 30 else 15
-        
-        return score
-    }
-    
-    private fun calculatePersonalityScore(p1: PersonalityTraits, p2: PersonalityTraits): Int {
-        var score = 0
-        
-        // Introvert/Extrovert compatibility (0-40 points)
-        // Similar levels or complementary (both moderate) work best
-        val ieDiff = kotlin.math.abs(p1.introvertExtrovert - p2.introvertExtrovert)
-        score += maxOf(0, 40 - ieDiff * 12)
-        
-        // Conflict resolution (0-30 points)
-        score += if (p1.conflictResolution == p2.conflictResolution) 30 else 15
-        
-        // Adaptability (0-30 points)
-        val adaptDiff = kotlin.math.abs(p1.adaptability - p2.adaptability)
-        score += maxOf(0, 30 - adaptDiff * 8)
-        
-        return score
-    }
-    
-    // Helper to parse time string to minutes
-    private fun parseTime(time: String): Int {
-        // Format: "11:00 PM" or "7:00 AM"
-        val parts = time.replace(" AM", "").replace(" PM", "").split(":")
-        var hours = parts.getOrNull(0)?.toIntOrNull() ?: 0
-        val minutes = parts.getOrNull(1)?.toIntOrNull() ?: 0
+    /**
+     * Bounded min-heap of (score, row); the root is the current K-th best.
+     * Earlier rows win ties.
+     */
+    private class TopMatches(private val capacity: Int) {
+        private val scores = IntArray(capacity)
+        private val rows = IntArray(capacity)
+        private var size = 0
+        
+        // Score a candidate must at least reach to enter
+        val threshold: Int get() = if (size < capacity || capacity == 0) Int.MIN_VALUE else scores[0]
+        
+        fun offer(row: Int, score: Int) {
+            if (size < capacity) {
+                scores[size] = score
+                rows[size] = row
+                siftUp(size++)
+            } else if (capacity > 0 && (score > scores[0] || (score == scores[0] && row < rows[0]))) {
+                scores[0] = score
+                rows[0] = row
+                siftDown(0)
+            }
+        }
         
-        if (time.contains("PM") && hours != 12) hours += 12
-        if (time.contains("AM") && hours == 12) hours = 0
+        /**
+         * Rows best first.
+         * Time: O(K log K)
+         */
+        fun drain(): IntArray {
+            val result = IntArray(size)
+            for (i in size - 1 downTo 0) {
+                result[i] = rows[0]
+                size--
+                scores[0] = scores[size]
+                rows[0] = rows[size]
+                siftDown(0)
+            }
+            return result
+        }
         
-        return hours * 60 + minutes
-    }
-    
-    private fun generateMatchReasons(
-        lifestyle: Int, study: Int, cleanliness: Int,
-        social: Int, sleep: Int, personality: Int
-    ): List<String> {
-        val reasons = mutableListOf<String>()
+        // a ranks below b: lower score, or same score and later row
+        private fun worse(a: Int, b: Int): Boolean =
+            scores[a] < scores[b] || (scores[a] == scores[b] && rows[a] > rows[b])
+        
+        private fun siftUp(from: Int) {
+            var child = from
+            while (child > 0) {
+                val parent = (child - 1) / 2
+                if (!worse(child, parent)) break
+                swap(child, parent)
+                child = parent
+            }
+        }
         
-        if (lifestyle >= 80) reasons.add("🏠 Similar lifestyle habits")
-        if (study >= 80) reasons.add("📚 Compatible study preferences")
-        if (cleanliness >= 80) reasons.add("🧹 Similar cleanliness standards")
-        if (social >= 80) reasons.add("👥 Matching social preferences")
-        if (sleep >= 80) reasons.add("😴 Compatible sleep schedules")
-        if (personality >= 80) reasons.add("🧠 Complementary personalities")
+        private fun siftDown(from: Int) {
+            var parent = from
+            while (true) {
+                val left = 2 * parent + 1
+                if (left >= size) break
+                val right = left + 1
+                val child = if (right < size && worse(right, left)) right else left
+                if (!worse(child, parent)) break
+                swap(child, parent)
+                parent = child
+            }
+        }
         
-        return reasons
+        private fun swap(a: Int, b: Int) {
+            val score = scores[a]
+            scores[a] = scores[b]
+            scores[b] = score
+            val row = rows[a]
+            rows[a] = rows[b]
+            rows[b] = row
+        }
     }
     
-    private fun generateWarnings(s1: RoommateSurvey, s2: RoommateSurvey): List<String> {
-        val warnings = mutableListOf<String>()
-        
-        // Smoking conflict
-        if (s1.lifestyle.smokingHabit != s2.lifestyle.smokingHabit) {
-            warnings.add("⚠️ Different smoking habits")
-        }
+    companion object {
+        
+        /**
+         * Edge for a scored pair: category scores laid out as in
+         * [SurveyFeatureMatrix.score], warning bits from [SurveyFeatureMatrix.warnings].
+         */
+        internal fun buildScore(
+            studentId1: String,
+            studentId2: String,
+            overallScore: Int,
+            categories: IntArray,
+            warningBits: Int,
+            version1: Long,
+            version2: Long,
+            profileVersion: Long,
+            calculatedAt: Long
+        ): CompatibilityScore = CompatibilityScore(
+            id = "${studentId1}_${studentId2}",
+            studentId1 = studentId1,
+            studentId2 = studentId2,
+            overallScore = overallScore,
+            lifestyleScore = categories[SurveyFeatureMatrix.LIFESTYLE],
+            studyScore = categories[SurveyFeatureMatrix.STUDY],
+            cleanlinessScore = categories[SurveyFeatureMatrix.CLEANLINESS],
+            socialScore = categories[SurveyFeatureMatrix.SOCIAL],
+            sleepScore = categories[SurveyFeatureMatrix.SLEEP],
+            personalityScore = categories[SurveyFeatureMatrix.PERSONALITY],
+            matchReasons = generateMatchReasons(categories),
+            warnings = generateWarnings(warningBits),
+            survey1Version = version1,
+            survey2Version = version2,
+            profileVersion = profileVersion,
+            calculatedAt = calculatedAt
+        )
         
-        // Food preference conflict
-        if (s1.lifestyle.foodPreference != s2.lifestyle.foodPreference) {
-            warnings.add("⚠️ Different food preferences")
+        private fun generateMatchReasons(categories: IntArray): List<String> {
+            val reasons = mutableListOf<String>()
+            
+            if (categories[SurveyFeatureMatrix.LIFESTYLE] >= 80) reasons.add("🏠 Similar lifestyle habits")
+            if (categories[SurveyFeatureMatrix.STUDY] >= 80) reasons.add("📚 Compatible study preferences")
+            if (categories[SurveyFeatureMatrix.CLEANLINESS] >= 80) reasons.add("🧹 Similar cleanliness standards")
+            if (categories[SurveyFeatureMatrix.SOCIAL] >= 80) reasons.add("👥 Matching social preferences")
+            if (categories[SurveyFeatureMatrix.SLEEP] >= 80) reasons.add("😴 Compatible sleep schedules")
+            if (categories[SurveyFeatureMatrix.PERSONALITY] >= 80) reasons.add("🧠 Complementary personalities")
+            
+            return reasons
         }
         
-        // Extreme sleep schedule difference
-        val bedDiff = kotlin.math.abs(
-            parseTime(s1.sleepSchedule.typicalBedtime) - 
-            parseTime(s2.sleepSchedule.typicalBedtime)
-        )
-        if (bedDiff > 180) { // More than 3 hours
-            warnings.add("⚠️ Significantly different sleep schedules")
+        private fun generateWarnings(bits: Int): List<String> {
+            val warnings = mutableListOf<String>()
+            
+            if (bits and SurveyFeatureMatrix.WARN_SMOKING != 0) {
+                warnings.add("⚠️ Different smoking habits")
+            }
+            if (bits and SurveyFeatureMatrix.WARN_FOOD != 0) {
+                warnings.add("⚠️ Different food preferences")
+            }
+            // More than 3 hours apart at bedtime
+            if (bits and SurveyFeatureMatrix.WARN_SLEEP != 0) {
+                warnings.add("⚠️ Significantly different sleep schedules")
+            }
+            if (bits and SurveyFeatureMatrix.WARN_DEAL_BREAKER != 0) {
+                warnings.add("⛔ Conflicts with a deal-breaker")
+            }
+            
+            return warnings
         }
-        
-        return warnings
     }
 }
 
@@ -0,0 +1,414 @@
+package com.hosteldada.core.domain.algorithm
+
+/**
+ * ============================================
+ * ROARING BITMAP
+ * ============================================
+ * 
+ * Compressed bitmap over non-negative Ints, after Roaring (Lemire et al.).
+ * Values are grouped by their high 16 bits into containers; a container
+ * keeps the low 16 bits either as a sorted CharArray (sparse, at most 4096
+ * values) or as a 1024-word LongArray (dense). The representation is picked
+ * per container after every operation, so small facets stay small and
+ * large ones intersect a word at a time.
+ * 
+ * Instances are immutable; results share no mutable state with inputs.
+ * 
+ * Time Complexity:
+ * - contains: O(log c + log 4096) where c is the container count
+ * - and / or / andNot: O(c1 + c2) containers, each O(n1 + n2) for arrays,
+ *   O(1024) words for bitmaps
+ * - Space: 2 bytes per value when sparse, 8 KB per 65536 values when dense
+ */
+internal class RoaringBitmap private constructor(
+    private val keys: CharArray,
+    private val containers: Array<Container>
+) {
+    
+    val cardinality: Int = containers.sumOf { it.cardinality }
+    
+    fun isEmpty(): Boolean = keys.isEmpty()
+    
+    operator fun contains(value: Int): Boolean {
+        if (value < 0) return false
+        val at = indexOfKey((value ushr 16).toChar())
+        return at >= 0 && containers[at].contains(value and LOW_MASK)
+    }
+    
+    /**
+     * Values in both bitmaps.
+     * Time: O(c1 + c2) container merges
+     */
+    fun and(other: RoaringBitmap): RoaringBitmap {
+        val outKeys = CharArray(minOf(keys.size, other.keys.size))
+        val out = arrayOfNulls<Container>(outKeys.size)
+        var size = 0
+        var i = 0
+        var j = 0
+        while (i < keys.size && j < other.keys.size) {
+            when {
+                keys[i] < other.keys[j] -> i++
+                keys[i] > other.keys[j] -> j++
+                else -> {
+                    val container = containers[i].and(other.containers[j])
+                    if (container.cardinality > 0) {
+                        outKeys[size] = keys[i]
+                        out[size++] = container
+                    }
+                    i++
+                    j++
+                }
+            }
+        }
+        return create(outKeys, out, size)
+    }
+    
+    /**
+     * Size of [and] without building it.
+     * Time: O(c1 + c2) container merges, no allocation
+     */
+    fun andCardinality(other: RoaringBitmap): Int {
+        var count = 0
+        var i = 0
+        var j = 0
+        while (i < keys.size && j < other.keys.size) {
+            when {
+                keys[i] < other.keys[j] -> i++
+                keys[i] > other.keys[j] -> j++
+                else -> count += containers[i++].andCardinality(other.containers[j++])
+            }
+        }
+        return count
+    }
+    
+    /**
+     * Values in either bitmap.
+     * Time: O(c1 + c2) container merges
+     */
+    fun or(other: RoaringBitmap): RoaringBitmap {
+        val outKeys = CharArray(keys.size + other.keys.size)
+        val out = arrayOfNulls<Container>(outKeys.size)
+        var size = 0
+        var i = 0
+        var j = 0
+        while (i < keys.size || j < other.keys.size) {
+            when {
+                j == other.keys.size || (i < keys.size && keys[i] < other.keys[j]) -> {
+                    outKeys[size] = keys[i]
+                    out[size++] = containers[i++]
+                }
+                i == keys.size || keys[i] > other.keys[j] -> {
+                    outKeys[size] = other.keys[j]
+                    out[size++] = other.containers[j++]
+                }
+                else -> {
+                    outKeys[size] = keys[i]
+                    out[size++] = containers[i++].or(other.containers[j++])
+                }
+            }
+        }
+        return create(outKeys, out, size)
+    }
+    
+    /**
+     * Values in this bitmap but not in [other], e.g. to clear a few bits.
+     * Time: O(c1 + c2) container merges
+     */
+    fun andNot(other: RoaringBitmap): RoaringBitmap {
+        val outKeys = CharArray(keys.size)
+        val out = arrayOfNulls<Container>(outKeys.size)
+        var size = 0
+        var j = 0
+        for (i in keys.indices) {
+            while (j < other.keys.size && other.keys[j] < keys[i]) j++
+            val container = if (j < other.keys.size && other.keys[j] == keys[i]) {
+                containers[i].andNot(other.containers[j])
+            } else {
+                containers[i]
+            }
+            if (container.cardinality > 0) {
+                outKeys[size] = keys[i]
+                out[size++] = container
+            }
+        }
+        return create(outKeys, out, size)
+    }
+    
+    /**
+     * Values in ascending order.
+     * Time: O(n + c * 1024) worst case for dense containers
+     */
+    fun toIntArray(): IntArray {
+        val result = IntArray(cardinality)
+        var size = 0
+        for (i in keys.indices) {
+            size = containers[i].copyInto(result, size, keys[i].code shl 16)
+        }
+        return result
+    }
+    
+    private fun indexOfKey(key: Char): Int {
+        var low = 0
+        var high = keys.size - 1
+        while (low <= high) {
+            val mid = (low + high) ushr 1
+            when {
+                keys[mid] < key -> low = mid + 1
+                keys[mid] > key -> high = mid - 1
+                else -> return mid
+            }
+        }
+        return -1
+    }
+    
+    // ==========================================
+    // Containers
+    // ==========================================
+    
+    private sealed class Container {
+        abstract val cardinality: Int
+        abstract fun contains(low: Int): Boolean
+        abstract fun and(other: Container): Container
+        abstract fun andCardinality(other: Container): Int
+        abstract fun or(other: Container): Container
+        abstract fun andNot(other: Container): Container
+        
+        /** Writes `high or low` for each value from [at]; returns the new end. */
+        abstract fun copyInto(target: IntArray, at: Int, high: Int): Int
+    }
+    
+    private class ArrayContainer(val values: CharArray) : Container() {
+        
+        override val cardinality: Int get() = values.size
+        
+        override fun contains(low: Int): Boolean {
+            var from = 0
+            var to = values.size - 1
+            val key = low.toChar()
+            while (from <= to) {
+                val mid = (from + to) ushr 1
+                when {
+                    values[mid] < key -> from = mid + 1
+                    values[mid] > key -> to = mid - 1
+                    else -> return true
+                }
+            }
+            return false
+        }
+        
+        override fun and(other: Container): Container = when (other) {
+            is ArrayContainer -> {
+                val out = CharArray(minOf(values.size, other.values.size))
+                var size = 0
+                var i = 0
+                var j = 0
+                while (i < values.size && j < other.values.size) {
+                    when {
+                        values[i] < other.values[j] -> i++
+                        values[i] > other.values[j] -> j++
+                        else -> {
+                            out[size++] = values[i++]
+                            j++
+                        }
+                    }
+                }
+                ArrayContainer(out.copyOf(size))
+            }
+            is BitmapContainer -> {
+                val out = CharArray(values.size)
+                var size = 0
+                for (value in values) {
+                    if (other.contains(value.code)) out[size++] = value
+                }
+                ArrayContainer(out.copyOf(size))
+            }
+        }
+        
+        override fun andCardinality(other: Container): Int = when (other) {
+            is ArrayContainer -> {
+                var count = 0
+                var i = 0
+                var j = 0
+                while (i < values.size && j < other.values.size) {
+                    when {
+                        values[i] < other.values[j] -> i++
+                        values[i] > other.values[j] -> j++
+                        else -> {
+                            count++
+                            i++
+                            j++
+                        }
+                    }
+                }
+                count
+            }
+            is BitmapContainer -> values.count { other.contains(it.code) }
+        }
+        
+        override fun or(other: Container): Container = when (other) {
+            is ArrayContainer -> {
+                val out = CharArray(values.size + other.values.size)
+                var size = 0
+                var i = 0
+                var j = 0
+                while (i < values.size || j < other.values.size) {
+                    out[size++] = when {
+                        j == other.values.size || (i < values.size && values[i] < other.values[j]) -> values[i++]
+                        i == values.size || values[i] > other.values[j] -> other.values[j++]
+                        else -> {
+                            j++
+                            values[i++]
+                        }
+                    }
+                }
+                if (size <= ARRAY_MAX) ArrayContainer(out.copyOf(size)) else BitmapContainer.of(out, size)
+            }
+            is BitmapContainer -> other.or(this)
+        }
+        
+        override fun andNot(other: Container): Container {
+            val out = CharArray(values.size)
+            var size = 0
+            for (value in values) {
+                if (!other.contains(value.code)) out[size++] = value
+            }
+            return if (size == values.size) this else ArrayContainer(out.copyOf(size))
+        }
+        
+        override fun copyInto(target: IntArray, at: Int, high: Int): Int {
+            var end = at
+            for (value in values) target[end++] = high or value.code
+            return end
+        }
+    }
+    
+    private class BitmapContainer(
+        val words: LongArray,
+        override val cardinality: Int
+    ) : Container() {
+        
+        override fun contains(low: Int): Boolean = (words[low ushr 6] and (1L shl low)) != 0L
+        
+        override fun and(other: Container): Container = when (other) {
+            is ArrayContainer -> other.and(this)
+            is BitmapContainer -> fromWords(LongArray(WORDS) { words[it] and other.words[it] })
+        }
+        
+        override fun andCardinality(other: Container): Int = when (other) {
+            is ArrayContainer -> other.andCardinality(this)
+            is BitmapContainer -> {
+                var count = 0
+                for (i in 0 until WORDS) count += (words[i] and other.words[i]).countOneBits()
+                count
+            }
+        }
+        
+        override fun or(other: Container): Container = when (other) {
+            is ArrayContainer -> {
+                val out = words.copyOf()
+                var count = cardinality
+                for (value in other.values) {
+                    val word = value.code ushr 6
+                    val bit = 1L shl value.code
+                    if (out[word] and bit == 0L) {
+                        out[word] = out[word] or bit
+                        count++
+                    }
+                }
+                BitmapContainer(out, count)
+            }
+            is BitmapContainer -> {
+                val out = LongArray(WORDS) { words[it] or other.words[it] }
+                BitmapContainer(out, out.sumOf { it.countOneBits() })
+            }
+        }
+        
+        override fun andNot(other: Container): Container = when (other) {
+            is ArrayContainer -> {
+                val out = words.copyOf()
+                for (value in other.values) {
+                    val word = value.code ushr 6
+                    out[word] = out[word] and (1L shl value.code).inv()
+                }
+                fromWords(out)
+            }
+            is BitmapContainer -> fromWords(LongArray(WORDS) { words[it] and other.words[it].inv() })
+        }
+        
+        override fun copyInto(target: IntArray, at: Int, high: Int): Int {
+            var end = at
+            for (i in 0 until WORDS) {
+                var word = words[i]
+                while (word != 0L) {
+                    target[end++] = high or (i shl 6) or word.countTrailingZeroBits()
+                    word = word and (word - 1)
+                }
+            }
+            return end
+        }
+        
+        companion object {
+            
+            fun of(values: CharArray, size: Int): BitmapContainer {
+                val words = LongArray(WORDS)
+                for (i in 0 until size) {
+                    val value = values[i].code
+                    words[value ushr 6] = words[value ushr 6] or (1L shl value)
+                }
+                return BitmapContainer(words, size)
+            }
+            
+            // Drops back to an array once sparse enough
+            fun fromWords(words: LongArray): Container {
+                val count = words.sumOf { it.countOneBits() }
+                if (count > ARRAY_MAX) return BitmapContainer(words, count)
+                
+                val values = CharArray(count)
+                var size = 0
+                for (i in 0 until WORDS) {
+                    var word = words[i]
+                    while (word != 0L) {
+                        values[size++] = ((i shl 6) or word.countTrailingZeroBits()).toChar()
+                        word = word and (word - 1)
+                    }
+                }
+                return ArrayContainer(values)
+            }
+        }
+    }
+    
+    companion object {
+        private const val LOW_MASK = 0xFFFF
+        private const val ARRAY_MAX = 4096
+        private const val WORDS = 1024
+        
+        val EMPTY = RoaringBitmap(CharArray(0), emptyArray())
+        
+        /**
+         * Bitmap of `values[0 until size]`, which must be sorted, distinct
+         * and non-negative.
+         * Time: O(n)
+         */
+        fun fromSorted(values: IntArray, size: Int = values.size): RoaringBitmap {
+            val keys = CharArray(size)
+            val containers = arrayOfNulls<Container>(size)
+            var count = 0
+            var start = 0
+            while (start < size) {
+                val high = values[start] ushr 16
+                var end = start
+                while (end < size && values[end] ushr 16 == high) end++
+                
+                val low = CharArray(end - start) { (values[start + it] and LOW_MASK).toChar() }
+                keys[count] = high.toChar()
+                containers[count++] = if (low.size <= ARRAY_MAX) ArrayContainer(low) else BitmapContainer.of(low, low.size)
+                start = end
+            }
+            return create(keys, containers, count)
+        }
+        
+        @Suppress("UNCHECKED_CAST")
+        private fun create(keys: CharArray, containers: Array<Container?>, size: Int): RoaringBitmap =
+            RoaringBitmap(keys.copyOf(size), containers.copyOf(size) as Array<Container>)
+    }
+}
@@ -0,0 +1,185 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.FoodPreference
+import com.hosteldada.core.domain.model.ScoringPoints
+import com.hosteldada.core.domain.model.ScoringProfile
+import com.hosteldada.core.domain.model.StudyStyle
+
+/**
+ * ============================================
+ * SCORING PLAN
+ * ============================================
+ * 
+ * A [ScoringProfile] compiled into lookup tables for the pair kernel in
+ * [SurveyFeatureMatrix], once per run:
+ * - Clock terms: points by absolute minute difference
+ * - 1-5 scale terms: points by absolute difference (0..255)
+ * - Enum answers: a value x value matrix
+ * - Habit flags: points by the XOR of both students' flag bits, so all
+ *   habit terms of a category are one lookup
+ * - Free-text answers: match / mismatch points on vocabulary codes
+ * 
+ * Category weights stay doubles applied in a fixed order, so the default
+ * profile scores exactly like the built-in constants did.
+ * 
+ * Time Complexity:
+ * - Compile: O(T) for T table entries (a few thousand)
+ * - Every lookup: O(1)
+ */
+class ScoringPlan private constructor(
+    // Clock tables, by |minutes|
+    internal val sleepTime: IntArray,
+    internal val wakeTime: IntArray,
+    internal val bedtime: IntArray,
+    internal val typicalWakeTime: IntArray,
+    
+    // Enum pair matrices, row-major by ordinal
+    internal val food: IntArray,
+    internal val studyStyle: IntArray,
+    
+    // By the XOR of the two students' category flag bits
+    internal val lifestyleFlags: IntArray,
+    internal val studyFlags: IntArray,
+    
+    // Scale tables, by |difference|
+    internal val organization: IntArray,
+    internal val sharedItems: IntArray,
+    internal val privacy: IntArray,
+    internal val introvertExtrovert: IntArray,
+    internal val adaptability: IntArray,
+    
+    internal val points: ScoringPoints,
+    
+    internal val lifestyleWeight: Double,
+    internal val studyWeight: Double,
+    internal val cleanlinessWeight: Double,
+    internal val socialWeight: Double,
+    internal val sleepWeight: Double,
+    internal val personalityWeight: Double
+) {
+    
+    internal val foods = FoodPreference.values().size
+    internal val studyStyles = StudyStyle.values().size
+    
+    // Category maxima, for optimistic bounds
+    internal val maxLifestyle = sleepTime[0] + wakeTime[0] + food.max() + lifestyleFlags.max()
+    internal val maxStudy = studyStyle.max() + studyFlags.max() + maxOf(points.studyTimeMatch, points.studyTimeMismatch)
+    internal val maxCleanliness = maxOf(points.cleaningMatch, points.cleaningMismatch) +
+        organization[0] + sharedItems[0]
+    internal val maxSocial = maxOf(points.visitorMatch, points.visitorMismatch) +
+        maxOf(points.partyMatch, points.partyMismatch) + privacy[0]
+    internal val maxSleepSensitivity = maxOf(points.sensitivityMatch, points.sensitivityMismatch)
+    internal val maxSleep = bedtime[0] + typicalWakeTime[0] + maxSleepSensitivity
+    internal val maxPersonality = introvertExtrovert[0] + maxOf(points.conflictMatch, points.conflictMismatch) +
+        adaptability[0]
+    
+    /** Highest overall score any pair can reach under this plan. */
+    val maxOverall: Int = weigh(maxLifestyle, maxStudy, maxCleanliness, maxSocial, maxSleep, maxPersonality)
+    
+    /**
+     * Weighted overall score; category order is fixed so results are
+     * reproducible bit for bit.
+     */
+    internal fun weigh(
+        lifestyle: Int,
+        study: Int,
+        cleanliness: Int,
+        social: Int,
+        sleep: Int,
+        personality: Int
+    ): Int = (
+        lifestyle * lifestyleWeight +
+        study * studyWeight +
+        cleanliness * cleanlinessWeight +
+        social * socialWeight +
+        sleep * sleepWeight +
+        personality * personalityWeight
+    ).toInt()
+    
+    companion object {
+        
+        /** Plan of [ScoringProfile.DEFAULT]. */
+        val DEFAULT: ScoringPlan by lazy { compile(ScoringProfile.DEFAULT) }
+        
+        // Largest scale difference a byte column can hold
+        private const val SCALE_DIFFS = 256
+        
+        /** Shared [DEFAULT] when [profile] scores like the default one, otherwise a fresh compile. */
+        fun of(profile: ScoringProfile): ScoringPlan {
+            val default = ScoringProfile.DEFAULT
+            return if (profile.weights == default.weights && profile.points == default.points) DEFAULT else compile(profile)
+        }
+        
+        /**
+         * Compile [profile] into tables. Points and weights must be
+         * non-negative and steps positive.
+         * Time: O(T)
+         */
+        fun compile(profile: ScoringProfile): ScoringPlan {
+            val p = profile.points
+            val w = profile.weights
+            require(listOf(w.lifestyle, w.study, w.cleanliness, w.social, w.sleep, w.personality).all { it >= 0.0 }) {
+                "Category weights must be non-negative"
+            }
+            validate(p)
+            
+            return ScoringPlan(
+                sleepTime = clockTable(p.sleepTimeMax, p.sleepTimeStepMinutes),
+                wakeTime = clockTable(p.wakeTimeMax, p.wakeTimeStepMinutes),
+                bedtime = clockTable(p.bedtimeMax, p.bedtimeStepMinutes),
+                typicalWakeTime = clockTable(p.typicalWakeTimeMax, p.typicalWakeTimeStepMinutes),
+                food = pairMatrix(FoodPreference.values().size, p.foodMatch, p.foodMismatch),
+                studyStyle = pairMatrix(StudyStyle.values().size, p.studyStyleMatch, p.studyStyleMismatch),
+                lifestyleFlags = flagTable(p.smokingMatch, p.smokingMismatch, p.drinkingMatch, p.drinkingMismatch),
+                studyFlags = flagTable(p.quietMatch, p.quietMismatch, p.musicMatch, p.musicMismatch),
+                organization = scaleTable(p.organizationMax, p.organizationStep),
+                sharedItems = scaleTable(p.sharedItemsMax, p.sharedItemsStep),
+                privacy = scaleTable(p.privacyMax, p.privacyStep),
+                introvertExtrovert = scaleTable(p.introvertExtrovertMax, p.introvertExtrovertStep),
+                adaptability = scaleTable(p.adaptabilityMax, p.adaptabilityStep),
+                points = p,
+                lifestyleWeight = w.lifestyle,
+                studyWeight = w.study,
+                cleanlinessWeight = w.cleanliness,
+                socialWeight = w.social,
+                sleepWeight = w.sleep,
+                personalityWeight = w.personality
+            )
+        }
+        
+        // max(0, max - minutes / step); the last entry is 0 and covers every larger gap
+        private fun clockTable(max: Int, stepMinutes: Int): IntArray {
+            require(max >= 0 && stepMinutes > 0) { "Clock terms need max >= 0 and step > 0" }
+            return IntArray(max * stepMinutes + 1) { maxOf(0, max - it / stepMinutes) }
+        }
+        
+        // max(0, max - difference * step)
+        private fun scaleTable(max: Int, step: Int): IntArray {
+            require(max >= 0 && step > 0) { "Scale terms need max >= 0 and step > 0" }
+            return IntArray(SCALE_DIFFS) { maxOf(0, max - it * step) }
+        }
+        
+        private fun pairMatrix(values: Int, match: Int, mismatch: Int): IntArray =
+            IntArray(values * values) { if (it / values == it % values) match else mismatch }
+        
+        // Bit 0 set: first habit differs; bit 1 set: second habit differs
+        private fun flagTable(firstMatch: Int, firstMismatch: Int, secondMatch: Int, secondMismatch: Int): IntArray =
+            IntArray(4) {
+                (if (it and 1 == 0) firstMatch else firstMismatch) +
+                    (if (it and 2 == 0) secondMatch else secondMismatch)
+            }
+        
+        private fun validate(points: ScoringPoints) {
+            val matchPoints = with(points) {
+                listOf(
+                    foodMatch, foodMismatch, smokingMatch, smokingMismatch, drinkingMatch, drinkingMismatch,
+                    studyStyleMatch, studyStyleMismatch, quietMatch, quietMismatch, studyTimeMatch,
+                    studyTimeMismatch, musicMatch, musicMismatch, cleaningMatch, cleaningMismatch,
+                    visitorMatch, visitorMismatch, partyMatch, partyMismatch, sensitivityMatch,
+                    sensitivityMismatch, conflictMatch, conflictMismatch
+                )
+            }
+            require(matchPoints.all { it >= 0 }) { "Points must be non-negative" }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.Snack
+
+/**
+ * ============================================
+ * SNACK CATALOG DIFF
+ * ============================================
+ * 
+ * Changes between two catalog snapshots, e.g. consecutive observeSnacks()
+ * emissions, computed once and handed to every search structure so each
+ * can do the least work its layout allows:
+ * - Flag-only changes (availability, stock) touch no indexed text and no
+ *   ranking key, so indexes patch the changed snacks in place
+ * - Indexes that assign ordinals in ranking order keep them as long as no
+ *   snack was added or removed and no changed snack moved
+ * - Anything else rebuilds
+ * 
+ * Time Complexity:
+ * - Between: O(n) comparisons
+ * - Patch: O(n + c) where c is changed snacks
+ */
+class SnackCatalogDiff private constructor(
+    val added: List<Snack>,
+    val removed: List<Snack>,
+    val changed: List<Change>
+) {
+    
+    /**
+     * One snack present in both snapshots with different fields.
+     */
+    class Change(val old: Snack, val new: Snack) {
+        
+        // Availability and stock are neither indexed nor ranked
+        val isFlagOnly: Boolean
+            get() = old.copy(
+                isAvailable = new.isAvailable,
+                stockQuantity = new.stockQuantity,
+                updatedAt = new.updatedAt
+            ) == new
+    }
+    
+    val isEmpty: Boolean
+        get() = added.isEmpty() && removed.isEmpty() && changed.isEmpty()
+    
+    val hasMembershipChanges: Boolean
+        get() = added.isNotEmpty() || removed.isNotEmpty()
+    
+    /** True if only availability or stock changed, e.g. an order was placed */
+    val isFlagOnly: Boolean
+        get() = !hasMembershipChanges && changed.all { it.isFlagOnly }
+    
+    /**
+     * Copy of [ranked] with every changed snack replaced at its ordinal, for
+     * indexes whose ordinals follow [ranking]. Null if snacks were added or
+     * removed, if [ranked] is out of step with the old snapshot, or if a
+     * replacement would leave its neighbours out of order; rebuild then.
+     * 
+     * Time: O(n + c)
+     */
+    fun patch(ranked: Array<Snack>, ordinalById: Map<String, Int>, ranking: Comparator<Snack>): Array<Snack>? {
+        if (hasMembershipChanges) return null
+        
+        val patched = ranked.copyOf()
+        val ordinals = IntArray(changed.size)
+        changed.forEachIndexed { i, change ->
+            val ordinal = ordinalById[change.old.id] ?: return null
+            if (patched[ordinal] != change.old) return null
+            patched[ordinal] = change.new
+            ordinals[i] = ordinal
+        }
+        
+        // Unchanged neighbours were in order, so only pairs next to a change can break it
+        for (ordinal in ordinals) {
+            if (ordinal > 0 && ranking.compare(patched[ordinal - 1], patched[ordinal]) > 0) return null
+            if (ordinal < patched.size - 1 && ranking.compare(patched[ordinal], patched[ordinal + 1]) > 0) return null
+        }
+        return patched
+    }
+    
+    companion object {
+        
+        /**
+         * Diff two catalog snapshots by snack id.
+         * Time: O(n)
+         */
+        fun between(previous: List<Snack>, current: List<Snack>): SnackCatalogDiff {
+            val before = previous.associateBy { it.id }
+            val after = current.associateBy { it.id }
+            
+            val added = ArrayList<Snack>()
+            val changed = ArrayList<Change>()
+            after.values.forEach { snack ->
+                val old = before[snack.id]
+                when {
+                    old == null -> added.add(snack)
+                    old != snack -> changed.add(Change(old, snack))
+                }
+            }
+            val removed = before.values.filter { it.id !in after }
+            
+            return SnackCatalogDiff(added, removed, changed)
+        }
+    }
+}
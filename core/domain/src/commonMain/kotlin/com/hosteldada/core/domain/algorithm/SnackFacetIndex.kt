@@ -0,0 +1,326 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.Snack
+import com.hosteldada.core.domain.model.SnackCategory
+import kotlinx.atomicfu.atomic
+
+/**
+ * ============================================
+ * SNACK FACET INDEX
+ * ============================================
+ * 
+ * Precomputed [RoaringBitmap]s over the catalog, one per category, diet
+ * flag, availability and price band, so any combination of menu filters
+ * (and a list of search results) resolves by bitmap intersection with no
+ * repository I/O.
+ * 
+ * - Ordinals are assigned in ranking order, so a filtered bitmap already
+ *   lists snacks in result order
+ * - Facet counts are computed per facet under the other facets' selection,
+ *   so a chip shows how many snacks tapping it would return
+ * - The index is immutable and rebuilt per catalog; readers take the
+ *   current one through an atomic reference and never block
+ * - Catalog changes that keep every snack's rank (stock, availability,
+ *   diet, price) patch only the bits of the changed ordinals
+ * 
+ * Time Complexity:
+ * - Rebuild: O(n log n)
+ * - Patch: O(n + c log c) plus merges of the touched bitmaps
+ * - Select / counts: O(f c) bitmap operations where f is the number of
+ *   facet values and c the container count (1 per 65536 snacks)
+ * - Space: O(n) per facet dimension
+ */
+class SnackFacetIndex(
+    ranking: Comparator<Snack> = SnackRanking()
+) {
+    
+    // Written by the single writer that also calls rebuild and applyDiff
+    private var ranking: Comparator<Snack> = ranking
+    
+    private class Index(
+        val snacks: Array<Snack>,
+        val ordinalById: Map<String, Int>,
+        val all: RoaringBitmap,
+        val categories: Array<RoaringBitmap>,
+        val vegetarian: RoaringBitmap,
+        val available: RoaringBitmap,
+        val priceBands: Array<RoaringBitmap>
+    ) {
+        companion object {
+            val EMPTY = Index(
+                emptyArray(),
+                emptyMap(),
+                RoaringBitmap.EMPTY,
+                Array(SnackCategory.values().size) { RoaringBitmap.EMPTY },
+                RoaringBitmap.EMPTY,
+                RoaringBitmap.EMPTY,
+                Array(PriceBand.values().size) { RoaringBitmap.EMPTY }
+            )
+        }
+    }
+    
+    // Which facet to leave out when counting that facet's values
+    private enum class Facet { CATEGORY, DIET, PRICE }
+    
+    // Ordinals entering and leaving one facet bitmap
+    private class BitmapPatch {
+        private val entering = ArrayList<Int>()
+        private val leaving = ArrayList<Int>()
+        
+        fun update(ordinal: Int, was: Boolean, now: Boolean) {
+            if (was == now) return
+            if (now) entering.add(ordinal) else leaving.add(ordinal)
+        }
+        
+        fun applyTo(bitmap: RoaringBitmap): RoaringBitmap {
+            var result = bitmap
+            if (leaving.isNotEmpty()) result = result.andNot(RoaringBitmap.fromSorted(leaving.sorted().toIntArray()))
+            if (entering.isNotEmpty()) result = result.or(RoaringBitmap.fromSorted(entering.sorted().toIntArray()))
+            return result
+        }
+    }
+    
+    private val current = atomic(Index.EMPTY)
+    
+    /**
+     * Replace the indexed catalog.
+     * Time: O(n log n)
+     */
+    fun rebuild(snacks: List<Snack>) {
+        val ranked = snacks.sortedWith(ranking).toTypedArray()
+        val categories = Array(SnackCategory.values().size) { OrdinalBuffer(ranked.size) }
+        val priceBands = Array(PriceBand.values().size) { OrdinalBuffer(ranked.size) }
+        val vegetarian = OrdinalBuffer(ranked.size)
+        val available = OrdinalBuffer(ranked.size)
+        val ordinalById = HashMap<String, Int>(ranked.size)
+        
+        ranked.forEachIndexed { ordinal, snack ->
+            ordinalById[snack.id] = ordinal
+            categories[snack.category.ordinal].add(ordinal)
+            priceBands[PriceBand.of(snack.price).ordinal].add(ordinal)
+            if (snack.isVegetarian) vegetarian.add(ordinal)
+            if (snack.isAvailable) available.add(ordinal)
+        }
+        
+        current.value = Index(
+            snacks = ranked,
+            ordinalById = ordinalById,
+            all = RoaringBitmap.fromSorted(IntArray(ranked.size) { it }),
+            categories = Array(categories.size) { categories[it].toBitmap() },
+            vegetarian = vegetarian.toBitmap(),
+            available = available.toBitmap(),
+            priceBands = Array(priceBands.size) { priceBands[it].toBitmap() }
+        )
+    }
+    
+    /**
+     * Bring the index in line with [snacks], given their [diff] from the
+     * catalog indexed last. While no snack is added, removed or moved in
+     * rank, ordinals hold: changed snacks are swapped in place and only
+     * the bits of their ordinals are cleared or set in the bitmaps whose
+     * facet value changed, so a stock flip rewrites nothing and an
+     * availability flip one bitmap. Otherwise it rebuilds.
+     * 
+     * Time: O(n + c log c) plus merges of the touched bitmaps, O(n log n) to rebuild
+     */
+    fun applyDiff(snacks: List<Snack>, diff: SnackCatalogDiff) {
+        if (diff.isEmpty) return
+        
+        val index = current.value
+        val patched = diff.patch(index.snacks, index.ordinalById, ranking)
+        if (patched == null) {
+            rebuild(snacks)
+            return
+        }
+        
+        val categories = Array(index.categories.size) { BitmapPatch() }
+        val priceBands = Array(index.priceBands.size) { BitmapPatch() }
+        val vegetarian = BitmapPatch()
+        val available = BitmapPatch()
+        
+        for (change in diff.changed) {
+            val ordinal = index.ordinalById.getValue(change.new.id)
+            val old = change.old
+            val new = change.new
+            categories.forEachIndexed { category, patch ->
+                patch.update(ordinal, old.category.ordinal == category, new.category.ordinal == category)
+            }
+            val oldBand = PriceBand.of(old.price).ordinal
+            val newBand = PriceBand.of(new.price).ordinal
+            priceBands.forEachIndexed { band, patch -> patch.update(ordinal, oldBand == band, newBand == band) }
+            vegetarian.update(ordinal, old.isVegetarian, new.isVegetarian)
+            available.update(ordinal, old.isAvailable, new.isAvailable)
+        }
+        
+        current.value = Index(
+            snacks = patched,
+            ordinalById = index.ordinalById,
+            all = index.all,
+            categories = Array(categories.size) { categories[it].applyTo(index.categories[it]) },
+            vegetarian = vegetarian.applyTo(index.vegetarian),
+            available = available.applyTo(index.available),
+            priceBands = Array(priceBands.size) { priceBands[it].applyTo(index.priceBands[it]) }
+        )
+    }
+    
+    /**
+     * Snacks matching [selection]. With [within] (e.g. search results) only
+     * those snacks are considered and their order is kept; otherwise
+     * results come in ranking order.
+     * Time: O(f c + r)
+     */
+    fun select(selection: SnackFacetSelection, within: List<Snack>? = null): List<Snack> {
+        val index = current.value
+        val matches = narrow(index, scopeOf(index, within), selection, skip = null)
+        
+        if (within != null) {
+            return within.filter { snack ->
+                val ordinal = index.ordinalById[snack.id]
+                ordinal != null && ordinal in matches
+            }
+        }
+        return matches.toIntArray().map { index.snacks[it] }
+    }
+    
+    /**
+     * Result counts for every facet value under [selection].
+     * Time: O(f c), no result materialization
+     */
+    fun counts(selection: SnackFacetSelection, within: List<Snack>? = null): SnackFacetCounts {
+        val index = current.value
+        val scope = scopeOf(index, within)
+        
+        val byCategory = narrow(index, scope, selection, skip = Facet.CATEGORY)
+        val byDiet = narrow(index, scope, selection, skip = Facet.DIET)
+        val byPrice = narrow(index, scope, selection, skip = Facet.PRICE)
+        
+        return SnackFacetCounts(
+            total = narrow(index, scope, selection, skip = null).cardinality,
+            byCategory = SnackCategory.values().associateWith {
+                byCategory.andCardinality(index.categories[it.ordinal])
+            },
+            vegetarian = byDiet.andCardinality(index.vegetarian),
+            byPriceBand = PriceBand.values().associateWith {
+                byPrice.andCardinality(index.priceBands[it.ordinal])
+            }
+        )
+    }
+    
+    /**
+     * Re-rank the indexed catalog, e.g. after new order history arrives.
+     * An equal ranking is a no-op.
+     * Time: O(n log n)
+     */
+    fun setRanking(ranking: Comparator<Snack>) {
+        if (ranking == this.ranking) return
+        this.ranking = ranking
+        rebuild(current.value.snacks.asList())
+    }
+    
+    fun getSize(): Int = current.value.snacks.size
+    
+    fun clear() {
+        current.value = Index.EMPTY
+    }
+    
+    private fun scopeOf(index: Index, within: List<Snack>?): RoaringBitmap {
+        if (within == null) return index.all
+        
+        val ordinals = within.mapNotNull { index.ordinalById[it.id] }.toIntArray()
+        ordinals.sort()
+        return RoaringBitmap.fromSorted(ordinals.distinctSorted())
+    }
+    
+    /**
+     * AND of [scope] with every constraint in [selection] except [skip].
+     */
+    private fun narrow(
+        index: Index,
+        scope: RoaringBitmap,
+        selection: SnackFacetSelection,
+        skip: Facet?
+    ): RoaringBitmap {
+        var result = scope
+        if (skip != Facet.CATEGORY && selection.category != null) {
+            result = result.and(index.categories[selection.category.ordinal])
+        }
+        if (skip != Facet.DIET && selection.vegetarianOnly) {
+            result = result.and(index.vegetarian)
+        }
+        if (skip != Facet.PRICE && selection.priceBands.isNotEmpty()) {
+            val bands = selection.priceBands.fold(RoaringBitmap.EMPTY) { union, band ->
+                union.or(index.priceBands[band.ordinal])
+            }
+            result = result.and(bands)
+        }
+        if (selection.availableOnly) {
+            result = result.and(index.available)
+        }
+        return result
+    }
+    
+    // Ordinals arrive in increasing order
+    private class OrdinalBuffer(capacity: Int) {
+        private val values = IntArray(capacity)
+        private var size = 0
+        
+        fun add(ordinal: Int) {
+            values[size++] = ordinal
+        }
+        
+        fun toBitmap(): RoaringBitmap = RoaringBitmap.fromSorted(values, size)
+    }
+    
+    private fun IntArray.distinctSorted(): IntArray {
+        if (size < 2) return this
+        var count = 1
+        for (i in 1 until size) {
+            if (this[i] != this[count - 1]) this[count++] = this[i]
+        }
+        return copyOf(count)
+    }
+}
+
+/**
+ * Menu price bands; the last one is open-ended.
+ */
+enum class PriceBand(val min: Double, val maxExclusive: Double) {
+    UNDER_20(0.0, 20.0),
+    FROM_20_TO_50(20.0, 50.0),
+    FROM_50_TO_100(50.0, 100.0),
+    FROM_100_TO_200(100.0, 200.0),
+    ABOVE_200(200.0, Double.POSITIVE_INFINITY);
+    
+    companion object {
+        fun of(price: Double): PriceBand = values().firstOrNull { price < it.maxExclusive } ?: ABOVE_200
+    }
+}
+
+/**
+ * Menu filters. An empty [priceBands] set means any price; several bands
+ * are OR-ed together, everything else is AND-ed.
+ */
+data class SnackFacetSelection(
+    val category: SnackCategory? = null,
+    val vegetarianOnly: Boolean = false,
+    val priceBands: Set<PriceBand> = emptySet(),
+    val availableOnly: Boolean = false
+) {
+    companion object {
+        val ALL = SnackFacetSelection()
+    }
+}
+
+/**
+ * Result counts per facet value; [total] is the count for the selection itself.
+ */
+data class SnackFacetCounts(
+    val total: Int = 0,
+    val byCategory: Map<SnackCategory, Int> = emptyMap(),
+    val vegetarian: Int = 0,
+    val byPriceBand: Map<PriceBand, Int> = emptyMap()
+) {
+    companion object {
+        val EMPTY = SnackFacetCounts()
+    }
+}
@@ -0,0 +1,124 @@
+package com.hosteldada.core.domain.algorithm
+
+/**
+ * ============================================
+ * SNACK PHONETICS
+ * ============================================
+ * 
+ * Metaphone-style sound keys tuned for romanized Hindi snack names, so
+ * spellings students actually type collide:
+ * "samosa" / "samossa", "kachori" / "kachauri", "chai" / "chay",
+ * "paneer" / "panir", "bhaji" / "baji".
+ * 
+ * Rules, applied to an already folded word:
+ * - Vowels are dropped except a leading one; a non-initial y is a vowel,
+ *   and w or h after a vowel is silent ("chay", "chowmein", "chah")
+ * - Aspirates lose their h: kh, gh, ch(h), jh, th, dh, bh -> k, g, c, j, t, d, b
+ * - ph / f -> F, sh / s -> S, q / k / hard c -> K, soft c -> S, z / j -> J,
+ *   v / w -> V, x -> KS, "tch" -> C
+ * - Doubled consonants collapse ("samossa", "channa"); a vowel in between
+ *   keeps them apart ("papad")
+ * 
+ * Up to [MAX_CODES] codes of 5 bits are packed into one Long, first code in
+ * the high bits, so keys compare and hash as plain integers.
+ */
+internal object SnackPhonetics {
+    
+    const val MAX_CODES = 12
+    private const val CODE_BITS = 5
+    
+    private const val SKIP = 0
+    private const val VOWEL = 1
+    private const val B = 2
+    private const val C = 3
+    private const val D = 4
+    private const val F = 5
+    private const val G = 6
+    private const val H = 7
+    private const val J = 8
+    private const val K = 9
+    private const val L = 10
+    private const val M = 11
+    private const val N = 12
+    private const val P = 13
+    private const val R = 14
+    private const val S = 15
+    private const val T = 16
+    private const val V = 17
+    private const val Y = 18
+    
+    /**
+     * Packed sound key of a folded [word], or 0 if it has no sounds to key on.
+     * Time: O(k)
+     */
+    fun key(word: String): Long {
+        var key = 0L
+        var count = 0
+        var last = SKIP
+        
+        fun emit(code: Int) {
+            if (code == last || count == MAX_CODES) return
+            key = (key shl CODE_BITS) or code.toLong()
+            count++
+            last = code
+        }
+        
+        var i = 0
+        while (i < word.length) {
+            val c = word[i]
+            val next = if (i + 1 < word.length) word[i + 1] else ' '
+            var step = 1
+            when (c) {
+                'a', 'e', 'i', 'o', 'u' -> {
+                    if (i == 0) emit(VOWEL)
+                    last = SKIP
+                }
+                'y' -> if (i == 0) emit(Y) else last = SKIP
+                'w', 'h' -> when {
+                    i == 0 -> emit(if (c == 'w') V else H)
+                    c == 'w' && !isVowel(word[i - 1]) -> emit(V)
+                    // Silent after a vowel; after a consonant the digraph already dropped it
+                    else -> Unit
+                }
+                'c' -> when (next) {
+                    'h' -> {
+                        emit(C)
+                        step = 2
+                    }
+                    'e', 'i', 'y' -> emit(S)
+                    else -> emit(K)
+                }
+                't' -> if (next == 'c' && i + 2 < word.length && word[i + 2] == 'h') Unit else emit(T)
+                'p' -> if (next == 'h') {
+                    emit(F)
+                    step = 2
+                } else {
+                    emit(P)
+                }
+                'k', 'q' -> emit(K)
+                'z', 'j' -> emit(J)
+                'v' -> emit(V)
+                'x' -> {
+                    emit(K)
+                    emit(S)
+                }
+                'b' -> emit(B)
+                'd' -> emit(D)
+                'f' -> emit(F)
+                'g' -> emit(G)
+                'l' -> emit(L)
+                'm' -> emit(M)
+                'n' -> emit(N)
+                'r' -> emit(R)
+                's' -> emit(S)
+                else -> Unit
+            }
+            i += step
+        }
+        
+        if (count == 0) return 0L
+        return key shl (CODE_BITS * (MAX_CODES - count))
+    }
+    
+    private fun isVowel(c: Char): Boolean = c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u'
+}
@@ -0,0 +1,393 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.Snack
+import kotlinx.atomicfu.atomic
+import kotlin.math.ln
+
+/**
+ * ============================================
+ * SNACK RELEVANCE INDEX (BM25)
+ * ============================================
+ * 
+ * Full-text inverted index over name, tags and description, ranked with
+ * BM25 so "spicy" or "protein" find snacks that only mention them in the
+ * description.
+ * 
+ * Layout:
+ * - Terms are words folded with [SnackTextNormalizer]
+ * - Term frequency is field-weighted (name 3, tags 2, description 1) and
+ *   document length is the weighted word count
+ * - Each term keeps sorted ordinals with their precomputed BM25 impact,
+ *   split into blocks of [BLOCK_SIZE] with the block's max impact
+ * - Ordinals are assigned in ranking order, so equal scores keep it
+ * - Term statistics only depend on text, so catalog changes that keep
+ *   every snack's text and rank (stock, availability, price) swap the
+ *   snacks in place and reuse the postings
+ * 
+ * Query (Block-Max WAND):
+ * - Term cursors are kept sorted by current ordinal; the pivot is the first
+ *   ordinal whose summed term upper bounds can beat the current K-th score
+ * - The pivot is then checked against the max impacts of the blocks it
+ *   falls in, and whole blocks that cannot beat the K-th score are skipped
+ * - Only surviving pivots are fully scored, so top-K work grows with the
+ *   number of competitive documents, not the catalog
+ * 
+ * Time Complexity:
+ * - Rebuild: O(n log n + W) where W is total indexed words
+ * - Patch: O(n + c) where c is changed snacks
+ * - Search: O(t log t) per pivot, with skips of O(log gap) by galloping;
+ *   worst case O(P t log t) over P postings
+ * - Space: O(P) postings plus O(P / 64) block maxima
+ */
+class SnackRelevanceIndex(
+    ranking: Comparator<Snack> = SnackRanking()
+) {
+    
+    // Written by the single writer that also calls rebuild and applyDiff
+    private var ranking: Comparator<Snack> = ranking
+    
+    /**
+     * Postings of one term. [blockLast] and [blockMax] describe
+     * `docs[b * BLOCK_SIZE until (b + 1) * BLOCK_SIZE]` for block b.
+     */
+    private class Term(
+        val docs: IntArray,
+        val impacts: FloatArray,
+        val blockLast: IntArray,
+        val blockMax: FloatArray,
+        val maxImpact: Float
+    )
+    
+    private class Index(
+        val snacks: Array<Snack>,
+        val ordinalById: Map<String, Int>,
+        val terms: Map<String, Term>
+    ) {
+        companion object {
+            val EMPTY = Index(emptyArray(), emptyMap(), emptyMap())
+        }
+    }
+    
+    /**
+     * Iterator over one term's postings; [doc] is [EXHAUSTED] past the end.
+     */
+    private class Cursor(val term: Term) {
+        var position = 0
+        var doc = term.docs[0]
+        
+        val impact: Float get() = term.impacts[position]
+        
+        // Move to the first posting >= target
+        fun advance(target: Int) {
+            if (doc >= target) return
+            val found = PostingLists.gallop(term.docs, position, term.docs.size, target)
+            position = if (found >= 0) found else -(found + 1)
+            doc = if (position < term.docs.size) term.docs[position] else EXHAUSTED
+        }
+        
+        fun next() {
+            position++
+            doc = if (position < term.docs.size) term.docs[position] else EXHAUSTED
+        }
+        
+        /**
+         * Block that would hold [target]: the first one ending at or after
+         * it, or -1 past the last block.
+         */
+        fun blockOf(target: Int): Int {
+            val blocks = term.blockLast
+            val from = position / BLOCK_SIZE
+            val found = PostingLists.gallop(blocks, from, blocks.size, target)
+            val block = if (found >= 0) found else -(found + 1)
+            return if (block < blocks.size) block else -1
+        }
+    }
+    
+    /**
+     * Bounded min-heap of (score, ordinal); the root is the current K-th
+     * best. Lower ordinals win ties because they rank higher.
+     */
+    private class TopK(private val capacity: Int) {
+        private val scores = FloatArray(capacity)
+        private val docs = IntArray(capacity)
+        var size = 0
+            private set
+        
+        val threshold: Float get() = if (size < capacity) -1f else scores[0]
+        
+        fun offer(doc: Int, score: Float) {
+            if (size < capacity) {
+                scores[size] = score
+                docs[size] = doc
+                siftUp(size++)
+            } else if (score > scores[0]) {
+                scores[0] = score
+                docs[0] = doc
+                siftDown(0)
+            }
+        }
+        
+        /**
+         * Ordinals best first.
+         * Time: O(K log K)
+         */
+        fun drain(): IntArray {
+            val result = IntArray(size)
+            for (i in size - 1 downTo 0) {
+                result[i] = docs[0]
+                size--
+                scores[0] = scores[size]
+                docs[0] = docs[size]
+                siftDown(0)
+            }
+            return result
+        }
+        
+        // a is "worse" than b: lower score, or same score and later ordinal
+        private fun worse(a: Int, b: Int): Boolean =
+            scores[a] < scores[b] || (scores[a] == scores[b] && docs[a] > docs[b])
+        
+        private fun siftUp(from: Int) {
+            var child = from
+            while (child > 0) {
+                val parent = (child - 1) / 2
+                if (!worse(child, parent)) break
+                swap(child, parent)
+                child = parent
+            }
+        }
+        
+        private fun siftDown(from: Int) {
+            var parent = from
+            while (true) {
+                val left = 2 * parent + 1
+                if (left >= size) break
+                val right = left + 1
+                val child = if (right < size && worse(right, left)) right else left
+                if (!worse(child, parent)) break
+                swap(child, parent)
+                parent = child
+            }
+        }
+        
+        private fun swap(a: Int, b: Int) {
+            val score = scores[a]
+            scores[a] = scores[b]
+            scores[b] = score
+            val doc = docs[a]
+            docs[a] = docs[b]
+            docs[b] = doc
+        }
+    }
+    
+    private val current = atomic(Index.EMPTY)
+    
+    /**
+     * Replace the indexed catalog and recompute term statistics.
+     * Time: O(n log n + W)
+     */
+    fun rebuild(snacks: List<Snack>) {
+        val ranked = snacks.sortedWith(ranking).toTypedArray()
+        val lengths = IntArray(ranked.size)
+        val ordinalById = HashMap<String, Int>(ranked.size)
+        // term -> (ordinal, weighted tf) pairs, ordinals ascending
+        val frequencies = HashMap<String, MutableList<Long>>()
+        
+        ranked.forEachIndexed { ordinal, snack ->
+            ordinalById[snack.id] = ordinal
+            val counts = HashMap<String, Int>()
+            lengths[ordinal] += countWords(snack.name, NAME_WEIGHT, counts)
+            snack.tags.forEach { lengths[ordinal] += countWords(it, TAG_WEIGHT, counts) }
+            lengths[ordinal] += countWords(snack.description, DESCRIPTION_WEIGHT, counts)
+            
+            for ((word, tf) in counts) {
+                frequencies.getOrPut(word) { mutableListOf() }.add((ordinal.toLong() shl 32) or tf.toLong())
+            }
+        }
+        
+        val averageLength = if (ranked.isEmpty()) 1.0 else maxOf(1.0, lengths.sum().toDouble() / ranked.size)
+        val terms = HashMap<String, Term>(frequencies.size)
+        for ((word, postings) in frequencies) {
+            terms[word] = buildTerm(postings, lengths, averageLength, ranked.size)
+        }
+        
+        current.value = Index(ranked, ordinalById, terms)
+    }
+    
+    /**
+     * Bring the index in line with [snacks], given their [diff] from the
+     * catalog indexed last. Idf, document lengths and impacts only change
+     * with name, tags or description, so other changes that keep every
+     * snack's rank swap the snacks in place; filters and results then see
+     * fresh stock and availability. Otherwise it rebuilds.
+     * 
+     * Time: O(n + c) in place, O(n log n + W) to rebuild
+     */
+    fun applyDiff(snacks: List<Snack>, diff: SnackCatalogDiff) {
+        if (diff.isEmpty) return
+        
+        val index = current.value
+        if (diff.changed.none { changesText(it) }) {
+            val patched = diff.patch(index.snacks, index.ordinalById, ranking)
+            if (patched != null) {
+                current.value = Index(patched, index.ordinalById, index.terms)
+                return
+            }
+        }
+        rebuild(snacks)
+    }
+    
+    /**
+     * Best [limit] snacks for [query] by BM25, any term matching.
+     * Time: see class doc; sub-linear in catalog size when K is small
+     */
+    fun search(
+        query: String,
+        limit: Int = DEFAULT_LIMIT,
+        filter: SnackSearchFilter = SnackSearchFilter.DEFAULT
+    ): List<Snack> {
+        val index = current.value
+        if (limit <= 0) return emptyList()
+        
+        val cursors = SnackTextNormalizer.fold(query)
+            .split(' ')
+            .filter { it.isNotEmpty() }
+            .distinct()
+            .mapNotNull { index.terms[it] }
+            .map { Cursor(it) }
+            .toTypedArray()
+        if (cursors.isEmpty()) return emptyList()
+        
+        val top = TopK(minOf(limit, index.snacks.size))
+        
+        while (true) {
+            cursors.sortBy { it.doc }
+            val threshold = top.threshold
+            
+            // Pivot: first cursor where the running upper bound beats the threshold
+            var bound = 0f
+            var pivot = -1
+            for (i in cursors.indices) {
+                if (cursors[i].doc == EXHAUSTED) break
+                bound += cursors[i].term.maxImpact
+                if (bound > threshold) {
+                    pivot = i
+                    break
+                }
+            }
+            if (pivot < 0) break
+            val pivotDoc = cursors[pivot].doc
+            // Every term on the pivot ordinal has to be in the block bound
+            while (pivot + 1 < cursors.size && cursors[pivot + 1].doc == pivotDoc) pivot++
+            
+            // Block-max check over the blocks holding pivotDoc
+            var blockBound = 0f
+            var nextCandidate = if (pivot + 1 < cursors.size) cursors[pivot + 1].doc else EXHAUSTED
+            for (i in 0..pivot) {
+                val block = cursors[i].blockOf(pivotDoc)
+                if (block < 0) continue
+                blockBound += cursors[i].term.blockMax[block]
+                nextCandidate = minOf(nextCandidate, cursors[i].term.blockLast[block] + 1)
+            }
+            
+            if (blockBound <= threshold) {
+                // No ordinal in [pivotDoc, nextCandidate) can make the top K
+                for (i in 0..pivot) cursors[i].advance(nextCandidate)
+                continue
+            }
+            
+            if (cursors[0].doc == pivotDoc) {
+                var score = 0f
+                for (cursor in cursors) {
+                    if (cursor.doc != pivotDoc) continue
+                    score += cursor.impact
+                    cursor.next()
+                }
+                if (filter.admits(index.snacks[pivotDoc])) top.offer(pivotDoc, score)
+            } else {
+                for (i in 0 until pivot) cursors[i].advance(pivotDoc)
+            }
+        }
+        
+        return top.drain().map { index.snacks[it] }
+    }
+    
+    /**
+     * Re-rank the indexed catalog, e.g. after new order history arrives.
+     * An equal ranking is a no-op.
+     * Time: O(n log n + W)
+     */
+    fun setRanking(ranking: Comparator<Snack>) {
+        if (ranking == this.ranking) return
+        this.ranking = ranking
+        rebuild(current.value.snacks.asList())
+    }
+    
+    fun getSize(): Int = current.value.snacks.size
+    
+    fun clear() {
+        current.value = Index.EMPTY
+    }
+    
+    companion object {
+        const val DEFAULT_LIMIT = 20
+        
+        private const val BLOCK_SIZE = 64
+        private const val EXHAUSTED = Int.MAX_VALUE
+        
+        private const val NAME_WEIGHT = 3
+        private const val TAG_WEIGHT = 2
+        private const val DESCRIPTION_WEIGHT = 1
+        
+        // Standard BM25 saturation and length normalization
+        private const val K1 = 1.2
+        private const val B = 0.75
+        
+        private fun changesText(change: SnackCatalogDiff.Change): Boolean =
+            change.old.name != change.new.name ||
+                change.old.tags != change.new.tags ||
+                change.old.description != change.new.description
+        
+        /**
+         * Add [weight] per folded word of [text] to [counts].
+         * Returns the weighted word count.
+         */
+        private fun countWords(text: String, weight: Int, counts: HashMap<String, Int>): Int {
+            var words = 0
+            for (word in SnackTextNormalizer.fold(text).split(' ')) {
+                if (word.isEmpty()) continue
+                counts[word] = (counts[word] ?: 0) + weight
+                words += weight
+            }
+            return words
+        }
+        
+        /**
+         * Impacts and block maxima for one term.
+         * Time: O(df)
+         */
+        private fun buildTerm(postings: List<Long>, lengths: IntArray, averageLength: Double, documents: Int): Term {
+            val df = postings.size
+            val idf = ln(1.0 + (documents - df + 0.5) / (df + 0.5))
+            
+            val docs = IntArray(df)
+            val impacts = FloatArray(df)
+            for (i in 0 until df) {
+                val doc = (postings[i] ushr 32).toInt()
+                val tf = (postings[i] and 0xFFFFFFFFL).toDouble()
+                val norm = K1 * (1 - B + B * lengths[doc] / averageLength)
+                docs[i] = doc
+                impacts[i] = (idf * tf * (K1 + 1) / (tf + norm)).toFloat()
+            }
+            
+            val blocks = (df + BLOCK_SIZE - 1) / BLOCK_SIZE
+            val blockLast = IntArray(blocks) { docs[minOf(df, (it + 1) * BLOCK_SIZE) - 1] }
+            val blockMax = FloatArray(blocks) { block ->
+                var max = 0f
+                for (i in block * BLOCK_SIZE until minOf(df, (block + 1) * BLOCK_SIZE)) max = maxOf(max, impacts[i])
+                max
+            }
+            return Term(docs, impacts, blockLast, blockMax, blockMax.maxOrNull() ?: 0f)
+        }
+    }
+}
@@ -0,0 +1,200 @@
+package com.hosteldada.core.domain.algorithm
+
+/**
+ * ============================================
+ * SNACK TEXT NORMALIZER
+ * ============================================
+ * 
+ * One folding pipeline shared by indexing and querying:
+ * - Case folding and diacritic stripping ("Café" -> "cafe")
+ * - Devanagari transliteration with word-final schwa deletion ("समोसा" -> "samosa")
+ * - Punctuation and underscores become single spaces ("QUICK_BITES" -> "quick bites")
+ * 
+ * Every input char is resolved through tables built once, and output
+ * pieces are preallocated strings, so folding allocates only the result.
+ * Synonyms ("cold drink" -> beverages, "मैगी" -> maggi) are expanded at
+ * index time only; queries are just folded.
+ */
+internal object SnackTextNormalizer {
+    
+    private const val LATIN_END = 0x0180
+    private const val COMBINING_START = 0x0300
+    private const val COMBINING_END = 0x0370
+    private const val DEVANAGARI_START = 0x0900
+    private const val DEVANAGARI_END = 0x0980
+    private const val RIGHT_QUOTE = 0x2019
+    
+    // Devanagari char classes
+    private const val DEV_OTHER = 0
+    private const val DEV_VOWEL = 1
+    private const val DEV_CONSONANT = 2
+    private const val DEV_MATRA = 3
+    private const val DEV_SIGN = 4
+    private const val DEV_VIRAMA = 5
+    private const val DEV_NUKTA = 6
+    private const val DEV_SEPARATOR = 7
+    
+    // Output for U+0000..U+017F; null means separator
+    private val LATIN = arrayOfNulls<String>(LATIN_END)
+    
+    private val DEVANAGARI = arrayOfNulls<String>(DEVANAGARI_END - DEVANAGARI_START)
+    private val DEVANAGARI_KIND = IntArray(DEVANAGARI_END - DEVANAGARI_START)
+    
+    private const val INHERENT_VOWEL = 'a'
+    
+    init {
+        for (c in '0'..'9') LATIN[c.code] = c.toString()
+        for (c in 'a'..'z') {
+            LATIN[c.code] = c.toString()
+            LATIN[c.uppercaseChar().code] = c.toString()
+        }
+        // "Haldiram's" -> "haldirams"
+        LATIN['\''.code] = ""
+        
+        // Latin-1 Supplement from U+00C0, then Latin Extended-A from U+0100
+        latin(0x00C0, "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i")
+        latin(0x00D0, "d", "n", "o", "o", "o", "o", "o", null, "o", "u", "u", "u", "u", "y", "th", "ss")
+        latin(0x00E0, "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i")
+        latin(0x00F0, "d", "n", "o", "o", "o", "o", "o", null, "o", "u", "u", "u", "u", "y", "th", "y")
+        latinRun(0x0100, 0x0105, "a")
+        latinRun(0x0106, 0x010D, "c")
+        latinRun(0x010E, 0x0111, "d")
+        latinRun(0x0112, 0x011B, "e")
+        latinRun(0x011C, 0x0123, "g")
+        latinRun(0x0124, 0x0127, "h")
+        latinRun(0x0128, 0x0131, "i")
+        latinRun(0x0132, 0x0133, "ij")
+        latinRun(0x0134, 0x0135, "j")
+        latinRun(0x0136, 0x0138, "k")
+        latinRun(0x0139, 0x0142, "l")
+        latinRun(0x0143, 0x014B, "n")
+        latinRun(0x014C, 0x0151, "o")
+        latinRun(0x0152, 0x0153, "oe")
+        latinRun(0x0154, 0x0159, "r")
+        latinRun(0x015A, 0x0161, "s")
+        latinRun(0x0162, 0x0167, "t")
+        latinRun(0x0168, 0x0173, "u")
+        latinRun(0x0174, 0x0175, "w")
+        latinRun(0x0176, 0x0178, "y")
+        latinRun(0x0179, 0x017E, "z")
+        latinRun(0x017F, 0x017F, "s")
+        
+        // Hinglish spellings: long and short vowels fold together
+        devanagari(DEV_VOWEL, 0x0905, "a", "a", "i", "i", "u", "u", "ri")
+        devanagari(DEV_VOWEL, 0x090D, "e", "e", "e", "ai", "o", "o", "o", "au")
+        devanagari(
+            DEV_CONSONANT, 0x0915,
+            "k", "kh", "g", "gh", "n", "ch", "chh", "j", "jh", "n",
+            "t", "th", "d", "dh", "n", "t", "th", "d", "dh", "n", "n",
+            "p", "f", "b", "bh", "m", "y", "r", "r", "l", "l", "l", "v",
+            "sh", "sh", "s", "h"
+        )
+        devanagari(DEV_CONSONANT, 0x0958, "q", "kh", "g", "z", "d", "dh", "f", "y")
+        devanagari(DEV_MATRA, 0x093E, "a", "i", "i", "u", "u", "ri", "ri", "e", "e", "e", "ai", "o", "o", "o", "au")
+        devanagari(DEV_SIGN, 0x0901, "n", "n", "h")
+        devanagari(DEV_VIRAMA, 0x094D, "")
+        devanagari(DEV_NUKTA, 0x093C, "")
+        devanagari(DEV_SEPARATOR, 0x0964, "", "")
+        devanagari(DEV_OTHER, 0x0966, "0", "1", "2", "3", "4", "5", "6", "7", "8", "9")
+    }
+    
+    /**
+     * Canonical folded word -> extra words indexed with it. Values are
+     * folded as well, so Devanagari spellings become their transliteration.
+     */
+    private val SYNONYMS: Map<String, List<String>> = mapOf(
+        "beverages" to listOf("cold drink", "cold drinks", "soft drink", "drinks", "juice"),
+        "snacks" to listOf("nashta", "namkeen"),
+        "quick bites" to listOf("fast food"),
+        "meals" to listOf("khana", "thali", "lunch", "dinner"),
+        "desserts" to listOf("sweets", "mithai", "meetha"),
+        "maggi" to listOf("maggie", "noodles", "मैगी"),
+        "chai" to listOf("tea", "चाय"),
+        "tea" to listOf("chai", "चाय"),
+        "coffee" to listOf("kofi", "कॉफ़ी"),
+        "samosa" to listOf("समोसा"),
+        "paneer" to listOf("panir", "पनीर"),
+        "pakoda" to listOf("pakora", "पकोड़ा"),
+        "sandwich" to listOf("sandwitch", "सैंडविच"),
+        "biscuit" to listOf("biscuits", "बिस्कुट"),
+        "chips" to listOf("wafers", "चिप्स"),
+        "lassi" to listOf("लस्सी")
+    ).entries.associate { (word, synonyms) -> fold(word) to synonyms.map { fold(it) } }
+    
+    /**
+     * Fold [text] for indexing or lookup.
+     * Time: O(n), one allocation for the result
+     */
+    fun fold(text: CharSequence): String {
+        val out = StringBuilder(text.length + 4)
+        var pendingVowel = false
+        
+        for (c in text) {
+            val code = c.code
+            when {
+                code in DEVANAGARI_START until DEVANAGARI_END -> {
+                    val index = code - DEVANAGARI_START
+                    when (val kind = DEVANAGARI_KIND[index]) {
+                        DEV_MATRA -> {
+                            out.append(DEVANAGARI[index])
+                            pendingVowel = false
+                        }
+                        DEV_VIRAMA -> pendingVowel = false
+                        DEV_NUKTA -> Unit
+                        DEV_SEPARATOR -> {
+                            // Word-final schwa is silent
+                            pendingVowel = false
+                            appendSpace(out)
+                        }
+                        else -> {
+                            if (pendingVowel) out.append(INHERENT_VOWEL)
+                            val piece = DEVANAGARI[index]
+                            if (piece != null) out.append(piece)
+                            pendingVowel = kind == DEV_CONSONANT
+                        }
+                    }
+                }
+                code in COMBINING_START until COMBINING_END -> Unit
+                code == RIGHT_QUOTE -> Unit
+                else -> {
+                    pendingVowel = false
+                    if (code < LATIN_END) {
+                        val piece = LATIN[code]
+                        if (piece == null) appendSpace(out) else out.append(piece)
+                    } else if (c.isWhitespace()) {
+                        appendSpace(out)
+                    } else {
+                        out.append(c.lowercaseChar())
+                    }
+                }
+            }
+        }
+        
+        if (out.isNotEmpty() && out[out.length - 1] == ' ') out.setLength(out.length - 1)
+        return out.toString()
+    }
+    
+    /**
+     * Extra words to index alongside an already folded [word].
+     */
+    fun synonymsOf(word: String): List<String> = SYNONYMS[word] ?: emptyList()
+    
+    private fun appendSpace(out: StringBuilder) {
+        if (out.isNotEmpty() && out[out.length - 1] != ' ') out.append(' ')
+    }
+    
+    private fun latin(start: Int, vararg pieces: String?) {
+        pieces.forEachIndexed { i, piece -> LATIN[start + i] = piece }
+    }
+    
+    private fun latinRun(first: Int, last: Int, piece: String) {
+        for (code in first..last) LATIN[code] = piece
+    }
+    
+    private fun devanagari(kind: Int, start: Int, vararg pieces: String) {
+        pieces.forEachIndexed { i, piece ->
+            DEVANAGARI[start - DEVANAGARI_START + i] = piece
+            DEVANAGARI_KIND[start - DEVANAGARI_START + i] = kind
+        }
+    }
+}
@@ -0,0 +1,283 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.Snack
+import kotlinx.atomicfu.atomic
+
+/**
+ * ============================================
+ * SNACK TRIGRAM INDEX
+ * ============================================
+ * 
+ * Substring ("infix") search companion to [SnackSearchTrie], which only
+ * matches prefixes: "chips" finds "Potato Chips", "paneer" finds
+ * "Chilli Paneer Roll".
+ * 
+ * Layout:
+ * - Name, tags and category are folded with [SnackTextNormalizer]
+ * - Every 1-, 2- and 3-gram inside a field maps to a sorted IntArray of
+ *   ordinals; grams never cross field boundaries
+ * - Ordinals are assigned in ranking order, so posting order is result order
+ * 
+ * Query:
+ * - Up to 3 chars: the gram's posting list is the exact answer
+ * - Longer: galloping intersection of the query's trigram lists, smallest
+ *   first, then each survivor is verified against its folded text
+ * 
+ * Concurrency:
+ * - The index is immutable and rebuilt per catalog; readers take the
+ *   current one through an atomic reference and never block
+ * - Catalog changes that keep every snack's rank are applied to a copy:
+ *   changed snacks are swapped in place, and only the grams a snack's
+ *   text gained or lost have their posting lists copied
+ * 
+ * Time Complexity:
+ * - Rebuild: O(n log n + L) where L is total folded text length
+ * - Patch: O(n + G + c g) where G is distinct grams, g grams per snack
+ * - Search: O(q + s log(l / s) + c f) where c is candidates verified,
+ *   f their text length
+ * - Space: O(L) postings
+ */
+class SnackTrigramIndex(
+    ranking: Comparator<Snack> = SnackRanking()
+) {
+    
+    // Written by the single writer that also calls rebuild and applyDiff
+    private var ranking: Comparator<Snack> = ranking
+    
+    /**
+     * [texts] holds each ordinal's folded fields joined by [FIELD_SEPARATOR],
+     * name first; [nameEnds] marks where the name stops.
+     */
+    private class Index(
+        val snacks: Array<Snack>,
+        val ordinalById: Map<String, Int>,
+        val texts: Array<String>,
+        val nameEnds: IntArray,
+        val grams: Map<Long, IntArray>
+    ) {
+        companion object {
+            val EMPTY = Index(emptyArray(), emptyMap(), emptyArray(), IntArray(0), emptyMap())
+        }
+    }
+    
+    private class PostingBuilder {
+        var values = IntArray(4)
+        var size = 0
+        
+        // Ordinals arrive in increasing order, so a repeat is always the last one
+        fun add(ordinal: Int) {
+            if (size > 0 && values[size - 1] == ordinal) return
+            if (size == values.size) values = values.copyOf(size * 2)
+            values[size++] = ordinal
+        }
+    }
+    
+    private val current = atomic(Index.EMPTY)
+    
+    /**
+     * Replace the indexed catalog.
+     * Time: O(n log n + L)
+     */
+    fun rebuild(snacks: List<Snack>) {
+        val ranked = snacks.sortedWith(ranking).toTypedArray()
+        val texts = arrayOfNulls<String>(ranked.size)
+        val nameEnds = IntArray(ranked.size)
+        val ordinalById = HashMap<String, Int>(ranked.size)
+        val builders = HashMap<Long, PostingBuilder>()
+        
+        ranked.forEachIndexed { ordinal, snack ->
+            ordinalById[snack.id] = ordinal
+            val fields = fieldsOf(snack)
+            for (field in fields) addGrams(builders, field, ordinal)
+            texts[ordinal] = fields.joinToString(FIELD_SEPARATOR.toString())
+            nameEnds[ordinal] = fields[0].length
+        }
+        
+        val grams = HashMap<Long, IntArray>(builders.size)
+        for ((key, builder) in builders) grams[key] = builder.values.copyOf(builder.size)
+        
+        @Suppress("UNCHECKED_CAST")
+        current.value = Index(ranked, ordinalById, texts as Array<String>, nameEnds, grams)
+    }
+    
+    /**
+     * Bring the index in line with [snacks], given their [diff] from the
+     * catalog indexed last. While no snack is added, removed or moved in
+     * rank, ordinals hold: changed snacks are swapped in place, so filters
+     * and results see fresh stock and availability, and a snack whose name,
+     * tags or category changed only moves its ordinal between the posting
+     * lists of grams it lost and gained. Otherwise, or when more than
+     * 1/[REBUILD_DIVISOR] of the catalog was retexted, it rebuilds.
+     * 
+     * Time: O(n + c) for flag and price changes, O(n + G + c g) with text
+     * changes, O(n log n + L) to rebuild
+     */
+    fun applyDiff(snacks: List<Snack>, diff: SnackCatalogDiff) {
+        if (diff.isEmpty) return
+        
+        val index = current.value
+        val patched = diff.patch(index.snacks, index.ordinalById, ranking)
+        val retexted = diff.changed.filter { changesText(it) }
+        if (patched == null || retexted.size * REBUILD_DIVISOR > patched.size) {
+            rebuild(snacks)
+            return
+        }
+        if (retexted.isEmpty()) {
+            current.value = Index(patched, index.ordinalById, index.texts, index.nameEnds, index.grams)
+            return
+        }
+        
+        val texts = index.texts.copyOf()
+        val nameEnds = index.nameEnds.copyOf()
+        val grams = HashMap(index.grams)
+        
+        for (change in retexted) {
+            val ordinal = index.ordinalById.getValue(change.new.id)
+            val fields = fieldsOf(change.new)
+            val oldKeys = gramKeysOf(fieldsOf(change.old))
+            val newKeys = gramKeysOf(fields)
+            
+            for (key in oldKeys) {
+                if (key in newKeys) continue
+                val postings = PostingLists.remove(grams.getValue(key), ordinal)
+                if (postings.isEmpty()) grams.remove(key) else grams[key] = postings
+            }
+            for (key in newKeys) {
+                if (key !in oldKeys) grams[key] = PostingLists.insert(grams[key] ?: EMPTY_POSTINGS, ordinal)
+            }
+            texts[ordinal] = fields.joinToString(FIELD_SEPARATOR.toString())
+            nameEnds[ordinal] = fields[0].length
+        }
+        
+        current.value = Index(patched, index.ordinalById, texts, nameEnds, grams)
+    }
+    
+    /**
+     * Snacks whose name, tags or category contain [query] after folding.
+     * Name matches come first, then ranking order.
+     * Time: O(q + s log(l / s) + c f)
+     */
+    fun search(
+        query: String,
+        filter: SnackSearchFilter = SnackSearchFilter.DEFAULT,
+        limit: Int = Int.MAX_VALUE
+    ): List<Snack> {
+        val index = current.value
+        val folded = SnackTextNormalizer.fold(query)
+        if (folded.isEmpty() || limit <= 0) return emptyList()
+        
+        val nameHits = mutableListOf<Snack>()
+        val otherHits = mutableListOf<Snack>()
+        
+        // Gram postings only promise the grams occur, so every candidate is
+        // checked; for queries up to 3 chars the check always passes
+        for (ordinal in candidates(index, folded)) {
+            val snack = index.snacks[ordinal]
+            if (!filter.admits(snack)) continue
+            
+            val at = index.texts[ordinal].indexOf(folded)
+            if (at < 0) continue
+            if (at < index.nameEnds[ordinal]) {
+                nameHits.add(snack)
+                if (nameHits.size == limit) break
+            } else if (otherHits.size < limit) {
+                otherHits.add(snack)
+            }
+        }
+        
+        return (nameHits + otherHits).take(limit)
+    }
+    
+    /**
+     * Re-rank the indexed catalog, e.g. after new order history arrives.
+     * An equal ranking is a no-op.
+     * Time: O(n log n + L)
+     */
+    fun setRanking(ranking: Comparator<Snack>) {
+        if (ranking == this.ranking) return
+        this.ranking = ranking
+        rebuild(current.value.snacks.asList())
+    }
+    
+    fun getSize(): Int = current.value.snacks.size
+    
+    fun clear() {
+        current.value = Index.EMPTY
+    }
+    
+    /**
+     * Ordinals that may contain [folded], in ascending (ranking) order.
+     */
+    private fun candidates(index: Index, folded: String): IntArray {
+        if (folded.length <= GRAM_SIZE) {
+            return index.grams[gramKey(folded, 0, folded.length)] ?: EMPTY_POSTINGS
+        }
+        
+        val lists = ArrayList<IntArray>(folded.length - GRAM_SIZE + 1)
+        for (start in 0..folded.length - GRAM_SIZE) {
+            val postings = index.grams[gramKey(folded, start, GRAM_SIZE)] ?: return EMPTY_POSTINGS
+            if (lists.none { it === postings }) lists.add(postings)
+        }
+        lists.sortBy { it.size }
+        
+        var result = lists[0]
+        for (i in 1 until lists.size) {
+            if (result.isEmpty()) break
+            result = PostingLists.intersect(result, 0, result.size, lists[i], 0, lists[i].size)
+        }
+        return result
+    }
+    
+    private fun addGrams(builders: HashMap<Long, PostingBuilder>, field: String, ordinal: Int) {
+        forEachGram(field) { key -> builders.getOrPut(key) { PostingBuilder() }.add(ordinal) }
+    }
+    
+    companion object {
+        private const val GRAM_SIZE = 3
+        private const val FIELD_SEPARATOR = '\u0001'
+        // Diffs retexting more than 1/4 of the catalog are rebuilt
+        private const val REBUILD_DIVISOR = 4
+        private val EMPTY_POSTINGS = IntArray(0)
+        
+        private fun changesText(change: SnackCatalogDiff.Change): Boolean =
+            change.old.name != change.new.name ||
+                change.old.tags != change.new.tags ||
+                change.old.category != change.new.category
+        
+        /**
+         * Folded, non-empty fields of [snack], name first.
+         */
+        private fun fieldsOf(snack: Snack): List<String> {
+            val fields = ArrayList<String>(snack.tags.size + 2)
+            fields.add(SnackTextNormalizer.fold(snack.name))
+            snack.tags.mapTo(fields) { SnackTextNormalizer.fold(it) }
+            fields.add(SnackTextNormalizer.fold(snack.category.name))
+            return fields.filterIndexed { i, field -> i == 0 || field.isNotEmpty() }
+        }
+        
+        private inline fun forEachGram(field: String, action: (Long) -> Unit) {
+            for (start in field.indices) {
+                for (length in 1..minOf(GRAM_SIZE, field.length - start)) {
+                    action(gramKey(field, start, length))
+                }
+            }
+        }
+        
+        private fun gramKeysOf(fields: List<String>): Set<Long> {
+            val keys = HashSet<Long>()
+            for (field in fields) forEachGram(field) { keys.add(it) }
+            return keys
+        }
+        
+        /**
+         * Pack up to [GRAM_SIZE] chars and the gram length into one Long.
+         */
+        private fun gramKey(text: String, start: Int, length: Int): Long {
+            var key = length.toLong()
+            for (i in start until start + length) {
+                key = (key shl 16) or text[i].code.toLong()
+            }
+            return key
+        }
+    }
+}
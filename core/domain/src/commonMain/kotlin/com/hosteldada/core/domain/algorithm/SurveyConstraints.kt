@@ -0,0 +1,155 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.FoodPreference
+import com.hosteldada.core.domain.model.RoommateSurvey
+
+/**
+ * ============================================
+ * SURVEY CONSTRAINTS
+ * ============================================
+ * 
+ * Hard constraints between roommates, compiled into bitmasks so an
+ * incompatible pair is rejected with one AND before any weighted scoring.
+ * 
+ * - Every survey gets a trait mask (what the student is: smoker, drinker,
+ *   non-vegetarian, late sleeper) and an exclusion mask (the traits listed
+ *   in its [RoommateSurvey.dealBreakers]), packed into one Int
+ * - A pair is compatible when neither side excludes a trait of the other
+ * - [ConstraintIndex] inverts the masks into per-trait row bitsets, so the
+ *   candidates of a row are found without testing every pair
+ */
+enum class DealBreaker(private vararg val aliases: String) {
+    SMOKER("smoking", "smoker", "smokers"),
+    DRINKER("drinking", "drinker", "drinkers", "alcohol"),
+    NON_VEGETARIAN("non_vegetarian", "non_veg", "nonveg", "meat"),
+    LATE_SLEEPER("late_sleeper", "late_night", "night_owl");
+    
+    val bit: Int get() = 1 shl ordinal
+    
+    /** Whether a student with [survey] and [bedtime] (minutes) has this trait. */
+    internal fun appliesTo(survey: RoommateSurvey, bedtime: Int): Boolean = when (this) {
+        SMOKER -> survey.lifestyle.smokingHabit
+        DRINKER -> survey.lifestyle.drinkingHabit
+        NON_VEGETARIAN -> survey.lifestyle.foodPreference == FoodPreference.NON_VEGETARIAN
+        LATE_SLEEPER -> bedtime in LATE_BEDTIME_FROM until LATE_BEDTIME_TO
+    }
+    
+    companion object {
+        // Bedtime between 12:30 AM and 6:00 AM
+        private const val LATE_BEDTIME_FROM = 30
+        private const val LATE_BEDTIME_TO = 6 * 60
+        
+        private const val EXCLUDE_SHIFT = 16
+        private const val TRAIT_MASK = (1 shl EXCLUDE_SHIFT) - 1
+        
+        /**
+         * Deal-breaker named by a free-text survey answer ("Smoking",
+         * "no non-veg", "night owl"), or null if it is not one we enforce.
+         */
+        fun parse(value: String): DealBreaker? {
+            val key = value.trim().lowercase()
+                .map { if (it in 'a'..'z') it else '_' }
+                .joinToString("")
+                .trim('_')
+                .removePrefix("no_")
+            return values().firstOrNull { key == it.name.lowercase() || key in it.aliases }
+        }
+        
+        /**
+         * Packed trait and exclusion masks of [survey].
+         * Time: O(d) for d deal-breakers
+         */
+        internal fun maskOf(survey: RoommateSurvey, bedtime: Int): Int {
+            var traits = 0
+            for (dealBreaker in values()) {
+                if (dealBreaker.appliesTo(survey, bedtime)) traits = traits or dealBreaker.bit
+            }
+            var excludes = 0
+            for (value in survey.dealBreakers) {
+                val dealBreaker = parse(value) ?: continue
+                excludes = excludes or dealBreaker.bit
+            }
+            return traits or (excludes shl EXCLUDE_SHIFT)
+        }
+        
+        internal fun traitsOf(mask: Int): Int = mask and TRAIT_MASK
+        
+        internal fun excludesOf(mask: Int): Int = mask ushr EXCLUDE_SHIFT
+        
+        /** Neither side excludes a trait of the other. */
+        internal fun compatible(mask1: Int, mask2: Int): Boolean =
+            ((excludesOf(mask1) and mask2) or (excludesOf(mask2) and mask1)) and TRAIT_MASK == 0
+    }
+}
+
+/**
+ * Inverted index from each [DealBreaker] to the rows of a
+ * [SurveyFeatureMatrix] that have it and the rows that refuse it, as
+ * bitsets over rows. A snapshot: rebuild after the matrix changes.
+ * 
+ * Time Complexity:
+ * - Build: O(n)
+ * - Candidates of a row: O(c n / 64) for c constraints involved, plus
+ *   O(n) to list them
+ * - Space: 2 bitsets of n bits per deal-breaker
+ */
+class ConstraintIndex(private val features: SurveyFeatureMatrix) {
+    
+    private val size = features.size
+    private val words = (size + 63) ushr 6
+    private val holders = Array(DealBreaker.values().size) { LongArray(words) }
+    private val refusers = Array(DealBreaker.values().size) { LongArray(words) }
+    
+    // Union of every row's exclusions
+    private var anyExcludes = 0
+    
+    init {
+        for (row in 0 until size) {
+            val mask = features.constraintMask(row)
+            val traits = DealBreaker.traitsOf(mask)
+            val excludes = DealBreaker.excludesOf(mask)
+            anyExcludes = anyExcludes or excludes
+            for (bit in DealBreaker.values().indices) {
+                if (traits and (1 shl bit) != 0) holders[bit].set(row)
+                if (excludes and (1 shl bit) != 0) refusers[bit].set(row)
+            }
+        }
+    }
+    
+    /** Whether any survey declares a deal-breaker at all. */
+    val isUnconstrained: Boolean get() = anyExcludes == 0
+    
+    /**
+     * Rows at or after [from], other than [row] itself, compatible with
+     * [row], ascending.
+     * Time: O(c n / 64 + n)
+     */
+    fun candidates(row: Int, from: Int = 0): IntArray {
+        val mask = features.constraintMask(row)
+        val traits = DealBreaker.traitsOf(mask)
+        val excludes = DealBreaker.excludesOf(mask)
+        
+        // Rows with a trait this row refuses, or refusing a trait it has
+        val blocked = LongArray(words)
+        for (bit in DealBreaker.values().indices) {
+            if (excludes and (1 shl bit) != 0) blocked.orWith(holders[bit])
+            if (traits and (1 shl bit) != 0 && anyExcludes and (1 shl bit) != 0) blocked.orWith(refusers[bit])
+        }
+        blocked.set(row)
+        
+        val result = IntArray(maxOf(0, size - from))
+        var count = 0
+        for (candidate in maxOf(0, from) until size) {
+            if (blocked[candidate ushr 6] and (1L shl candidate) == 0L) result[count++] = candidate
+        }
+        return result.copyOf(count)
+    }
+    
+    private fun LongArray.set(row: Int) {
+        this[row ushr 6] = this[row ushr 6] or (1L shl row)
+    }
+    
+    private fun LongArray.orWith(other: LongArray) {
+        for (i in indices) this[i] = this[i] or other[i]
+    }
+}
@@ -0,0 +1,359 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.RoommateSurvey
+import kotlin.math.abs
+
+/**
+ * ============================================
+ * SURVEY FEATURE MATRIX
+ * ============================================
+ * 
+ * Every [RoommateSurvey] encoded once into a fixed-width row of primitives,
+ * stored structure-of-arrays so the pairwise compatibility kernel reads a
+ * few array slots per feature instead of walking survey objects.
+ * 
+ * Encoding:
+ * - Clock strings ("11:00 PM") -> minutes since midnight, parsed once
+ * - Enums -> ordinals; booleans -> bits in one flags byte
+ * - Free-text answers compared only for equality (cleaning frequency,
+ *   party attitude, ...) -> codes from a per-column vocabulary, so equal
+ *   strings get equal codes
+ * - 1-5 scales -> bytes (clamped to the byte range)
+ * - Deal-breakers -> packed trait / exclusion masks ([DealBreaker])
+ * 
+ * Points and weights come from a compiled [ScoringPlan], so every term is
+ * a table lookup on a difference, an XOR or an ordinal pair. Scores are
+ * identical to scoring the surveys field by field under the same profile.
+ * Writes are not thread-safe; once built, any number of threads may score
+ * rows.
+ * 
+ * Time Complexity:
+ * - Add / set: O(k) for k answer characters, amortized O(1) growth
+ * - Score a pair: O(1), no allocation
+ * - Space: ~49 bytes per survey plus the vocabularies
+ */
+class SurveyFeatureMatrix(
+    initialCapacity: Int = DEFAULT_CAPACITY,
+    val plan: ScoringPlan = ScoringPlan.DEFAULT
+) {
+    
+    private var capacity = initialCapacity.coerceAtLeast(1)
+    
+    /** Number of encoded rows. */
+    var size = 0
+        private set
+    
+    // Minutes since midnight
+    private var sleepTime = IntArray(capacity)
+    private var wakeTime = IntArray(capacity)
+    private var bedtime = IntArray(capacity)
+    private var typicalWakeTime = IntArray(capacity)
+    
+    // Ordinals and flag bits
+    private var food = ByteArray(capacity)
+    private var studyStyle = ByteArray(capacity)
+    private var flags = ByteArray(capacity)
+    private var constraints = IntArray(capacity)
+    
+    // Vocabulary codes
+    private var studyTime = IntArray(capacity)
+    private var cleaningFrequency = IntArray(capacity)
+    private var visitorFrequency = IntArray(capacity)
+    private var partyAttitude = IntArray(capacity)
+    private var sleepSensitivity = IntArray(capacity)
+    private var conflictResolution = IntArray(capacity)
+    
+    // 1-5 scales
+    private var organization = ByteArray(capacity)
+    private var sharedItems = ByteArray(capacity)
+    private var privacy = ByteArray(capacity)
+    private var introvertExtrovert = ByteArray(capacity)
+    private var adaptability = ByteArray(capacity)
+    
+    private val studyTimes = Vocabulary()
+    private val cleaningFrequencies = Vocabulary()
+    private val visitorFrequencies = Vocabulary()
+    private val partyAttitudes = Vocabulary()
+    private val sleepSensitivities = Vocabulary()
+    private val conflictResolutions = Vocabulary()
+    
+    /**
+     * Encode [survey] into a new row and return its index.
+     * Time: O(k) amortized
+     */
+    fun add(survey: RoommateSurvey): Int {
+        if (size == capacity) grow()
+        val row = size++
+        set(row, survey)
+        return row
+    }
+    
+    /**
+     * Re-encode [row] from [survey], e.g. after the survey was updated.
+     * Time: O(k)
+     */
+    fun set(row: Int, survey: RoommateSurvey) {
+        require(row in 0 until size) { "Row $row out of range 0..<$size" }
+        
+        val lifestyle = survey.lifestyle
+        val study = survey.studyHabits
+        val cleanliness = survey.cleanliness
+        val social = survey.socialPreferences
+        val sleep = survey.sleepSchedule
+        val personality = survey.personalityTraits
+        
+        sleepTime[row] = parseTime(lifestyle.sleepTime)
+        wakeTime[row] = parseTime(lifestyle.wakeTime)
+        bedtime[row] = parseTime(sleep.typicalBedtime)
+        typicalWakeTime[row] = parseTime(sleep.typicalWakeTime)
+        
+        food[row] = lifestyle.foodPreference.ordinal.toByte()
+        studyStyle[row] = study.studyStyle.ordinal.toByte()
+        
+        studyTime[row] = studyTimes.codeOf(study.preferredStudyTime)
+        cleaningFrequency[row] = cleaningFrequencies.codeOf(cleanliness.cleaningFrequency)
+        visitorFrequency[row] = visitorFrequencies.codeOf(social.visitorFrequency)
+        partyAttitude[row] = partyAttitudes.codeOf(social.partyAttitude)
+        sleepSensitivity[row] = sleepSensitivities.codeOf(sleep.sleepSensitivity)
+        conflictResolution[row] = conflictResolutions.codeOf(personality.conflictResolution)
+        
+        organization[row] = scale(cleanliness.organizationLevel)
+        sharedItems[row] = scale(cleanliness.sharedItemsComfort)
+        privacy[row] = scale(social.privacyNeeds)
+        introvertExtrovert[row] = scale(personality.introvertExtrovert)
+        adaptability[row] = scale(personality.adaptability)
+        
+        var bits = 0
+        if (lifestyle.smokingHabit) bits = bits or SMOKING
+        if (lifestyle.drinkingHabit) bits = bits or DRINKING
+        if (study.needsQuietEnvironment) bits = bits or QUIET
+        if (study.musicWhileStudying) bits = bits or MUSIC
+        flags[row] = bits.toByte()
+        constraints[row] = DealBreaker.maskOf(survey, bedtime[row])
+    }
+    
+    /**
+     * Drop every row. Vocabularies are kept, so codes stay stable.
+     */
+    fun clear() {
+        size = 0
+    }
+    
+    // ==========================================
+    // Pair scoring kernel
+    // ==========================================
+    
+    /**
+     * Whether neither row has a trait the other listed as a deal-breaker.
+     * Time: O(1), one AND per side
+     */
+    fun compatible(a: Int, b: Int): Boolean = DealBreaker.compatible(constraints[a], constraints[b])
+    
+    /** Packed deal-breaker masks of [row]. */
+    fun constraintMask(row: Int): Int = constraints[row]
+    
+    /**
+     * Writes the six category scores of rows [a] and [b] into [categories]
+     * (indexed by [LIFESTYLE] .. [PERSONALITY]) and returns the weighted
+     * overall score.
+     * Time: O(1), no allocation
+     */
+    fun score(a: Int, b: Int, categories: IntArray): Int {
+        categories[LIFESTYLE] = lifestyleScore(a, b)
+        categories[STUDY] = studyScore(a, b)
+        categories[CLEANLINESS] = cleanlinessScore(a, b)
+        categories[SOCIAL] = socialScore(a, b)
+        categories[SLEEP] = sleepScore(a, b)
+        categories[PERSONALITY] = personalityScore(a, b)
+        return overall(categories)
+    }
+    
+    /**
+     * Weighted overall score from six category scores laid out as in [score].
+     */
+    fun overall(categories: IntArray): Int = plan.weigh(
+        categories[LIFESTYLE],
+        categories[STUDY],
+        categories[CLEANLINESS],
+        categories[SOCIAL],
+        categories[SLEEP],
+        categories[PERSONALITY]
+    )
+    
+    /**
+     * Weighted overall score of rows [a] and [b] only.
+     * Time: O(1), no allocation
+     */
+    fun overallScore(a: Int, b: Int): Int = plan.weigh(
+        lifestyleScore(a, b),
+        studyScore(a, b),
+        cleanlinessScore(a, b),
+        socialScore(a, b),
+        sleepScore(a, b),
+        personalityScore(a, b)
+    )
+    
+    /**
+     * Optimistic overall score of rows [a] and [b]: exact over the clock,
+     * food and habit columns (all of lifestyle, the sleep clock terms) with
+     * every other term at its maximum. Never below [overallScore], since
+     * it is the same weighted sum over terms that are each at least as high.
+     * Time: O(1), no allocation; about a third of the full kernel
+     */
+    fun upperBound(a: Int, b: Int): Int {
+        val sleepClock = clock(plan.bedtime, bedtime[a] - bedtime[b]) +
+            clock(plan.typicalWakeTime, typicalWakeTime[a] - typicalWakeTime[b])
+        return plan.weigh(
+            lifestyleScore(a, b),
+            plan.maxStudy,
+            plan.maxCleanliness,
+            plan.maxSocial,
+            sleepClock + plan.maxSleepSensitivity,
+            plan.maxPersonality
+        )
+    }
+    
+    /**
+     * Warning bits ([WARN_SMOKING], [WARN_FOOD], [WARN_SLEEP],
+     * [WARN_DEAL_BREAKER]) for the pair.
+     * Time: O(1), no allocation
+     */
+    fun warnings(a: Int, b: Int): Int {
+        var bits = 0
+        if (differs(a, b, SMOKING)) bits = bits or WARN_SMOKING
+        if (food[a] != food[b]) bits = bits or WARN_FOOD
+        if (abs(bedtime[a] - bedtime[b]) > MAX_BEDTIME_GAP) bits = bits or WARN_SLEEP
+        if (!compatible(a, b)) bits = bits or WARN_DEAL_BREAKER
+        return bits
+    }
+    
+    fun lifestyleScore(a: Int, b: Int): Int =
+        clock(plan.sleepTime, sleepTime[a] - sleepTime[b]) +
+            clock(plan.wakeTime, wakeTime[a] - wakeTime[b]) +
+            plan.food[food[a] * plan.foods + food[b]] +
+            plan.lifestyleFlags[habits(a, b) and HABIT_PAIR]
+    
+    fun studyScore(a: Int, b: Int): Int {
+        val points = plan.points
+        return plan.studyStyle[studyStyle[a] * plan.studyStyles + studyStyle[b]] +
+            plan.studyFlags[(habits(a, b) ushr STUDY_HABIT_SHIFT) and HABIT_PAIR] +
+            same(studyTime, a, b, points.studyTimeMatch, points.studyTimeMismatch)
+    }
+    
+    fun cleanlinessScore(a: Int, b: Int): Int {
+        val points = plan.points
+        return same(cleaningFrequency, a, b, points.cleaningMatch, points.cleaningMismatch) +
+            plan.organization[abs(organization[a] - organization[b])] +
+            plan.sharedItems[abs(sharedItems[a] - sharedItems[b])]
+    }
+    
+    fun socialScore(a: Int, b: Int): Int {
+        val points = plan.points
+        return same(visitorFrequency, a, b, points.visitorMatch, points.visitorMismatch) +
+            same(partyAttitude, a, b, points.partyMatch, points.partyMismatch) +
+            plan.privacy[abs(privacy[a] - privacy[b])]
+    }
+    
+    fun sleepScore(a: Int, b: Int): Int {
+        val points = plan.points
+        return clock(plan.bedtime, bedtime[a] - bedtime[b]) +
+            clock(plan.typicalWakeTime, typicalWakeTime[a] - typicalWakeTime[b]) +
+            same(sleepSensitivity, a, b, points.sensitivityMatch, points.sensitivityMismatch)
+    }
+    
+    fun personalityScore(a: Int, b: Int): Int {
+        val points = plan.points
+        return plan.introvertExtrovert[abs(introvertExtrovert[a] - introvertExtrovert[b])] +
+            same(conflictResolution, a, b, points.conflictMatch, points.conflictMismatch) +
+            plan.adaptability[abs(adaptability[a] - adaptability[b])]
+    }
+    
+    // Points of a clock term; gaps past the table all score its last entry (0)
+    private fun clock(table: IntArray, minutes: Int): Int = table[minOf(abs(minutes), table.size - 1)]
+    
+    // Match / mismatch points of a vocabulary column
+    private fun same(column: IntArray, a: Int, b: Int, match: Int, mismatch: Int): Int =
+        if (column[a] == column[b]) match else mismatch
+    
+    // Habit bits that differ between the two rows
+    private fun habits(a: Int, b: Int): Int = flags[a].toInt() xor flags[b].toInt()
+    
+    private fun differs(a: Int, b: Int, bit: Int): Boolean = ((flags[a].toInt() xor flags[b].toInt()) and bit) != 0
+    
+    private fun grow() {
+        capacity *= 2
+        sleepTime = sleepTime.copyOf(capacity)
+        wakeTime = wakeTime.copyOf(capacity)
+        bedtime = bedtime.copyOf(capacity)
+        typicalWakeTime = typicalWakeTime.copyOf(capacity)
+        food = food.copyOf(capacity)
+        studyStyle = studyStyle.copyOf(capacity)
+        flags = flags.copyOf(capacity)
+        constraints = constraints.copyOf(capacity)
+        studyTime = studyTime.copyOf(capacity)
+        cleaningFrequency = cleaningFrequency.copyOf(capacity)
+        visitorFrequency = visitorFrequency.copyOf(capacity)
+        partyAttitude = partyAttitude.copyOf(capacity)
+        sleepSensitivity = sleepSensitivity.copyOf(capacity)
+        conflictResolution = conflictResolution.copyOf(capacity)
+        organization = organization.copyOf(capacity)
+        sharedItems = sharedItems.copyOf(capacity)
+        privacy = privacy.copyOf(capacity)
+        introvertExtrovert = introvertExtrovert.copyOf(capacity)
+        adaptability = adaptability.copyOf(capacity)
+    }
+    
+    // Dense codes for the distinct answers of one free-text question
+    private class Vocabulary {
+        private val codes = HashMap<String, Int>()
+        
+        fun codeOf(value: String): Int = codes.getOrPut(value) { codes.size }
+    }
+    
+    companion object {
+        const val DEFAULT_CAPACITY = 64
+        
+        // Category slots in score()'s output
+        const val LIFESTYLE = 0
+        const val STUDY = 1
+        const val CLEANLINESS = 2
+        const val SOCIAL = 3
+        const val SLEEP = 4
+        const val PERSONALITY = 5
+        const val CATEGORY_COUNT = 6
+        
+        const val WARN_SMOKING = 1
+        const val WARN_FOOD = 2
+        const val WARN_SLEEP = 4
+        const val WARN_DEAL_BREAKER = 8
+        
+        // More than 3 hours apart
+        private const val MAX_BEDTIME_GAP = 180
+        
+        private const val SMOKING = 1
+        private const val DRINKING = 2
+        private const val QUIET = 4
+        private const val MUSIC = 8
+        
+        // Flag table index: two habit bits; study habits sit above lifestyle ones
+        private const val HABIT_PAIR = 3
+        private const val STUDY_HABIT_SHIFT = 2
+        
+        private fun scale(value: Int): Byte = value.coerceIn(Byte.MIN_VALUE.toInt(), Byte.MAX_VALUE.toInt()).toByte()
+        
+        /**
+         * Minutes since midnight of "11:00 PM" / "7:00 AM"; unparsable parts
+         * count as 0.
+         */
+        fun parseTime(time: String): Int {
+            val parts = time.replace(" AM", "").replace(" PM", "").split(":")
+            var hours = parts.getOrNull(0)?.toIntOrNull() ?: 0
+            val minutes = parts.getOrNull(1)?.toIntOrNull() ?: 0
+            
+            if (time.contains("PM") && hours != 12) hours += 12
+            if (time.contains("AM") && hours == 12) hours = 0
+            
+            return hours * 60 + minutes
+        }
+    }
+}
@@ -0,0 +1,131 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.RoommateSurvey
+import com.hosteldada.core.domain.model.Student
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+
+/**
+ * ============================================
+ * SURVEY PARTITIONS
+ * ============================================
+ * 
+ * Blocking layer for roommate matching. Rooms are never shared across
+ * gender or hostel block, so surveys are grouped by [PartitionKey]
+ * (gender, year, target hostel block) and every pair, top-K query and
+ * assignment runs inside one partition.
+ * 
+ * - Surveys keep their original order within a partition
+ * - Students without a known key share one partition, so with no student
+ *   data at all everything lands in a single partition
+ * - [widen] regroups by a coarser key for cross-partition fallbacks;
+ *   gender is never mixed
+ * - [mapParallel] processes partitions concurrently
+ * 
+ * Time Complexity:
+ * - Build: O(n)
+ * - Pairs to score: O(Σ nᵢ²) instead of O(n²)
+ */
+class SurveyPartitions(
+    private val surveys: List<RoommateSurvey>,
+    private val keyOf: (studentId: String) -> PartitionKey
+) {
+    
+    /** Partitions in order of their first survey. */
+    val partitions: List<SurveyPartition> = surveys
+        .groupBy { keyOf(it.studentId) }
+        .map { (key, members) -> SurveyPartition(key, members) }
+    
+    private val byStudent = HashMap<String, SurveyPartition>(surveys.size).apply {
+        partitions.forEach { partition -> partition.surveys.forEach { put(it.studentId, partition) } }
+    }
+    
+    /** Pairs within partitions, the only ones ever scored. */
+    val pairCount: Long = partitions.sumOf { it.pairCount }
+    
+    /**
+     * Partition holding [studentId]'s survey, or null if it has none.
+     * Time: O(1)
+     */
+    fun partitionOf(studentId: String): SurveyPartition? = byStudent[studentId]
+    
+    /**
+     * The same surveys grouped by keys widened per [fallback].
+     * Time: O(n)
+     */
+    fun widen(fallback: PartitionFallback): SurveyPartitions =
+        SurveyPartitions(surveys) { keyOf(it).widen(fallback) }
+    
+    /**
+     * Apply [transform] to every partition concurrently on [dispatcher];
+     * results keep partition order.
+     * Time: O(max partition cost) with enough workers
+     */
+    suspend fun <R> mapParallel(
+        dispatcher: CoroutineDispatcher,
+        transform: (SurveyPartition) -> R
+    ): List<R> = coroutineScope {
+        partitions.map { partition -> async(dispatcher) { transform(partition) } }.awaitAll()
+    }
+}
+
+/**
+ * Surveys of the students sharing [key].
+ */
+data class SurveyPartition(
+    val key: PartitionKey,
+    val surveys: List<RoommateSurvey>
+) {
+    val pairCount: Long get() = surveys.size.toLong() * (surveys.size - 1) / 2
+}
+
+/**
+ * Blocking key of a student. Text is compared case-insensitively; a blank
+ * [hostelBlock] or a [year] of [ANY_YEAR] matches any.
+ */
+data class PartitionKey(
+    val gender: String = "",
+    val year: Int = ANY_YEAR,
+    val hostelBlock: String = ""
+) {
+    
+    /**
+     * This key with the levels [fallback] allows to mix dropped.
+     */
+    fun widen(fallback: PartitionFallback): PartitionKey = copy(
+        year = if (fallback.mixesYears) ANY_YEAR else year,
+        hostelBlock = if (fallback.mixesBlocks) "" else hostelBlock
+    )
+    
+    /** Whether a room in [roomBlock] can house this partition. */
+    fun admitsBlock(roomBlock: String): Boolean =
+        hostelBlock.isEmpty() || normalize(roomBlock) == hostelBlock
+    
+    companion object {
+        const val ANY_YEAR = 0
+        
+        /** Key of students with no student record. */
+        val UNKNOWN = PartitionKey()
+        
+        fun of(student: Student): PartitionKey = PartitionKey(
+            gender = normalize(student.gender),
+            year = student.year,
+            hostelBlock = normalize(student.hostelBlock)
+        )
+        
+        private fun normalize(value: String): String = value.trim().lowercase()
+    }
+}
+
+/**
+ * Which partition levels may be mixed when a partition cannot fill its
+ * matches or rooms on its own. Gender is never mixed.
+ */
+enum class PartitionFallback(val mixesYears: Boolean, val mixesBlocks: Boolean) {
+    NONE(false, false),
+    ACROSS_YEARS(true, false),
+    ACROSS_BLOCKS(false, true),
+    ACROSS_YEARS_AND_BLOCKS(true, true)
+}
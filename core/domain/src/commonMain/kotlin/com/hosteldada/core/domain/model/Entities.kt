@@ -164,6 +164,8 @@ data class Student(
     val branch: String = "",
     val year: Int = 1,
     val gender: String = "",
+    // Block the student is to be housed in; blank until decided
+    val hostelBlock: String = "",
     val photoUrl: String = "",
     val createdAt: Long = 0
 )
@@ -275,9 +277,104 @@ data class CompatibilityScore(
     val personalityScore: Int = 0,
     val matchReasons: List<String> = emptyList(),
     val warnings: List<String> = emptyList(),
+    // updatedAt of each student's survey when the score was computed
+    val survey1Version: Long = 0,
+    val survey2Version: Long = 0,
+    // updatedAt of the scoring profile the score was computed with
+    val profileVersion: Long = 0,
     val calculatedAt: Long = 0
 )
 
+/**
+ * Admin-configurable compatibility scoring for a semester. The defaults
+ * reproduce the built-in scoring.
+ */
+@Serializable
+data class ScoringProfile(
+    val id: String = "",
+    val semester: String = "",
+    val weights: CategoryWeights = CategoryWeights(),
+    val points: ScoringPoints = ScoringPoints(),
+    val updatedAt: Long = 0
+) {
+    companion object {
+        val DEFAULT = ScoringProfile()
+    }
+}
+
+// Share of each category in the overall score
+@Serializable
+data class CategoryWeights(
+    val lifestyle: Double = 0.20,
+    val study: Double = 0.20,
+    val cleanliness: Double = 0.20,
+    val social: Double = 0.15,
+    val sleep: Double = 0.15,
+    val personality: Double = 0.10
+)
+
+/**
+ * Points per survey question. Clock terms lose one point per step of
+ * difference from their max; 1-5 scale terms lose one step per point of
+ * difference; everything else scores match or mismatch.
+ */
+@Serializable
+data class ScoringPoints(
+    // Lifestyle
+    val sleepTimeMax: Int = 25,
+    val sleepTimeStepMinutes: Int = 30,
+    val wakeTimeMax: Int = 25,
+    val wakeTimeStepMinutes: Int = 30,
+    val foodMatch: Int = 20,
+    val foodMismatch: Int = 10,
+    val smokingMatch: Int = 15,
+    val smokingMismatch: Int = 0,
+    val drinkingMatch: Int = 15,
+    val drinkingMismatch: Int = 0,
+    
+    // Study
+    val studyStyleMatch: Int = 30,
+    val studyStyleMismatch: Int = 15,
+    val quietMatch: Int = 25,
+    val quietMismatch: Int = 10,
+    val studyTimeMatch: Int = 25,
+    val studyTimeMismatch: Int = 12,
+    val musicMatch: Int = 20,
+    val musicMismatch: Int = 10,
+    
+    // Cleanliness
+    val cleaningMatch: Int = 35,
+    val cleaningMismatch: Int = 17,
+    val organizationMax: Int = 35,
+    val organizationStep: Int = 10,
+    val sharedItemsMax: Int = 30,
+    val sharedItemsStep: Int = 8,
+    
+    // Social
+    val visitorMatch: Int = 35,
+    val visitorMismatch: Int = 17,
+    val partyMatch: Int = 30,
+    val partyMismatch: Int = 15,
+    val privacyMax: Int = 35,
+    val privacyStep: Int = 10,
+    
+    // Sleep
+    val bedtimeMax: Int = 35,
+    val bedtimeStepMinutes: Int = 20,
+    val typicalWakeTimeMax: Int = 35,
+    val typicalWakeTimeStepMinutes: Int = 20,
+    val sensitivityMatch: Int = 30,
+    val sensitivityMismatch: Int = 15,
+    
+    // Personality
+    val introvertExtrovertMax: Int = 40,
+    val introvertExtrovertStep: Int = 12,
+    val conflictMatch: Int = 30,
+    val conflictMismatch: Int = 15,
+    val adaptabilityMax: Int = 30,
+    val adaptabilityStep: Int = 8
+)
+
 @Serializable
 data class Room(
     val id: String = "",
@@ -55,6 +55,10 @@ interface SnackRepository {
     suspend fun getSnacksByCategory(category: SnackCategory): Result<List<Snack>>
     suspend fun searchSnacks(query: String): Result<List<Snack>>
     
+    // Search index persisted for the current sync, see SnackSearchTrie.writeBinary
+    suspend fun loadSearchIndex(): ByteArray?
+    suspend fun saveSearchIndex(bytes: ByteArray)
+    
     // Admin operations
     suspend fun addSnack(snack: Snack): Result<String>
     suspend fun updateSnack(snack: Snack): Result<Unit>
@@ -134,6 +138,11 @@ interface CompatibilityRepository {
     suspend fun generateAllCompatibilities(semester: String): Result<List<CompatibilityScore>>
 }
 
+interface ScoringProfileRepository {
+    suspend fun getProfile(semester: String): Result<ScoringProfile?>
+    suspend fun saveProfile(profile: ScoringProfile): Result<Unit>
+}
+
 // ==========================================
 // FUTURE MODULES
 // ==========================================
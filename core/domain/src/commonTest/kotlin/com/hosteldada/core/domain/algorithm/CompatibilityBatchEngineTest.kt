@@ -0,0 +1,80 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.CompatibilityScore
+import com.hosteldada.core.domain.model.RoommateSurvey
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.test.runTest
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Tiled, parallel [CompatibilityBatchEngine.generatePartitioned] must
+ * persist exactly the pairs of the naive O(n²) loop over each partition,
+ * with the same scores.
+ */
+class CompatibilityBatchEngineTest {
+    
+    private val dealBreakers = listOf("smoking", "no non-veg", "night owl", "alcohol")
+    
+    @Test
+    fun tiledPartitionsMatchNaivePairLoop() = runTest {
+        val random = Random(SEED)
+        // Empty, single and multi-tile partitions, with ragged last tiles
+        val sizes = listOf(0, 1, 2, TILE_SIZE, TILE_SIZE + 1, 3 * TILE_SIZE - 2, 23)
+        var offset = 0
+        val partitions = sizes.map { size ->
+            ScoringPlanTest.randomSurveys(random, size, dealBreakers)
+                .map { it.copy(studentId = "student-${offset++}") }
+        }
+        
+        val engine = CompatibilityBatchEngine(Dispatchers.Default, parallelism = 4, tileSize = TILE_SIZE)
+        val persisted = ArrayList<CompatibilityScore>()
+        var lastProgress: CompatibilityProgress? = null
+        val saved = engine.generatePartitioned(partitions, onProgress = { lastProgress = it }) { persisted += it }
+        
+        val expected = partitions.flatMap { naivePairs(it) }
+        val actual = persisted.map { Edge(it.studentId1, it.studentId2, it.overallScore) }
+        
+        assertEquals(expected.size, actual.size, "no pair persisted twice")
+        assertEquals(expected.toSet(), actual.toSet())
+        assertEquals(expected.size.toLong(), saved)
+        
+        // Skipped pairs still count as processed
+        val totalPairs = partitions.sumOf { it.size.toLong() * (it.size - 1) / 2 }
+        assertTrue(saved < totalPairs, "some pairs are ruled out by deal-breakers")
+        assertEquals(CompatibilityProgress(saved, totalPairs, totalPairs), lastProgress)
+    }
+    
+    @Test
+    fun noPairsWithoutTwoSurveysInAPartition() = runTest {
+        val partitions = ScoringPlanTest.randomSurveys(Random(SEED), 3).map { listOf(it) }
+        val engine = CompatibilityBatchEngine(Dispatchers.Default, tileSize = TILE_SIZE)
+        
+        val saved = engine.generatePartitioned(partitions) { error("nothing to persist") }
+        assertEquals(0L, saved)
+    }
+    
+    // Every compatible pair of one partition, scored one at a time
+    private fun naivePairs(partition: List<RoommateSurvey>): List<Edge> {
+        val features = SurveyFeatureMatrix(partition.size.coerceAtLeast(1))
+        partition.forEach { features.add(it) }
+        
+        val edges = ArrayList<Edge>()
+        for (i in partition.indices) {
+            for (j in i + 1 until partition.size) {
+                if (!features.compatible(i, j)) continue
+                edges += Edge(partition[i].studentId, partition[j].studentId, features.overallScore(i, j))
+            }
+        }
+        return edges
+    }
+    
+    private data class Edge(val studentId1: String, val studentId2: String, val overallScore: Int)
+    
+    private companion object {
+        const val SEED = 19
+        const val TILE_SIZE = 4
+    }
+}
@@ -0,0 +1,192 @@
+package com.hosteldada.core.domain.algorithm
+
+import com.hosteldada.core.domain.model.*
+import kotlin.math.abs
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertSame
+
+/**
+ * The default [ScoringProfile] must score exactly like the constants
+ * that were hard-coded in [SurveyFeatureMatrix] before profiles existed.
+ * [LegacyScoring] keeps those formulas, field by field.
+ */
+class ScoringPlanTest {
+    
+    @Test
+    fun defaultPlanMatchesLegacyConstants() {
+        val surveys = randomSurveys(Random(SEED), 120)
+        
+        for (plan in listOf(ScoringPlan.DEFAULT, ScoringPlan.compile(ScoringProfile.DEFAULT))) {
+            val features = SurveyFeatureMatrix(surveys.size, plan)
+            surveys.forEach { features.add(it) }
+            val categories = IntArray(SurveyFeatureMatrix.CATEGORY_COUNT)
+            
+            for (a in surveys.indices) {
+                for (b in surveys.indices) {
+                    val expected = LegacyScoring.categories(surveys[a], surveys[b])
+                    val overall = features.score(a, b, categories)
+                    assertEquals(expected.toList(), categories.toList(), "categories of $a, $b")
+                    assertEquals(LegacyScoring.overall(expected), overall, "overall of $a, $b")
+                    assertEquals(overall, features.overallScore(a, b), "overallScore of $a, $b")
+                }
+            }
+        }
+    }
+    
+    @Test
+    fun defaultPlanTopsOutAtLegacyMaximum() {
+        assertEquals(LegacyScoring.MAX_SCORE, ScoringPlan.DEFAULT.maxOverall)
+    }
+    
+    @Test
+    fun defaultProfileSharesCompiledPlan() {
+        assertSame(ScoringPlan.DEFAULT, ScoringPlan.of(ScoringProfile(semester = "2026-odd")))
+    }
+    
+    /**
+     * Scoring as it was before [ScoringPlan]: fixed points per term and
+     * fixed category weights.
+     */
+    private object LegacyScoring {
+        const val MAX_SCORE = 100
+        
+        fun categories(a: RoommateSurvey, b: RoommateSurvey): IntArray = intArrayOf(
+            lifestyle(a, b), study(a, b), cleanliness(a, b), social(a, b), sleep(a, b), personality(a, b)
+        )
+        
+        fun overall(categories: IntArray): Int = (
+            categories[SurveyFeatureMatrix.LIFESTYLE] * 0.20 +
+            categories[SurveyFeatureMatrix.STUDY] * 0.20 +
+            categories[SurveyFeatureMatrix.CLEANLINESS] * 0.20 +
+            categories[SurveyFeatureMatrix.SOCIAL] * 0.15 +
+            categories[SurveyFeatureMatrix.SLEEP] * 0.15 +
+            categories[SurveyFeatureMatrix.PERSONALITY] * 0.10
+        ).toInt()
+        
+        private fun lifestyle(a: RoommateSurvey, b: RoommateSurvey): Int {
+            val x = a.lifestyle
+            val y = b.lifestyle
+            var score = 0
+            score += maxOf(0, 25 - minutesApart(x.sleepTime, y.sleepTime) / 30)
+            score += maxOf(0, 25 - minutesApart(x.wakeTime, y.wakeTime) / 30)
+            score += if (x.foodPreference == y.foodPreference) 20 else 10
+            if (x.smokingHabit == y.smokingHabit) score += 15
+            if (x.drinkingHabit == y.drinkingHabit) score += 15
+            return score
+        }
+        
+        private fun study(a: RoommateSurvey, b: RoommateSurvey): Int {
+            val x = a.studyHabits
+            val y = b.studyHabits
+            var score = 0
+            score += if (x.studyStyle == y.studyStyle) 30 else 15
+            score += if (x.needsQuietEnvironment == y.needsQuietEnvironment) 25 else 10
+            score += if (x.preferredStudyTime == y.preferredStudyTime) 25 else 12
+            score += if (x.musicWhileStudying == y.musicWhileStudying) 20 else 10
+            return score
+        }
+        
+        private fun cleanliness(a: RoommateSurvey, b: RoommateSurvey): Int {
+            val x = a.cleanliness
+            val y = b.cleanliness
+            var score = 0
+            score += if (x.cleaningFrequency == y.cleaningFrequency) 35 else 17
+            score += maxOf(0, 35 - abs(x.organizationLevel - y.organizationLevel) * 10)
+            score += maxOf(0, 30 - abs(x.sharedItemsComfort - y.sharedItemsComfort) * 8)
+            return score
+        }
+        
+        private fun social(a: RoommateSurvey, b: RoommateSurvey): Int {
+            val x = a.socialPreferences
+            val y = b.socialPreferences
+            var score = 0
+            score += if (x.visitorFrequency == y.visitorFrequency) 35 else 17
+            score += if (x.partyAttitude == y.partyAttitude) 30 else 15
+            score += maxOf(0, 35 - abs(x.privacyNeeds - y.privacyNeeds) * 10)
+            return score
+        }
+        
+        private fun sleep(a: RoommateSurvey, b: RoommateSurvey): Int {
+            val x = a.sleepSchedule
+            val y = b.sleepSchedule
+            var score = 0
+            score += maxOf(0, 35 - minutesApart(x.typicalBedtime, y.typicalBedtime) / 20)
+            score += maxOf(0, 35 - minutesApart(x.typicalWakeTime, y.typicalWakeTime) / 20)
+            score += if (x.sleepSensitivity == y.sleepSensitivity) 30 else 15
+            return score
+        }
+        
+        private fun personality(a: RoommateSurvey, b: RoommateSurvey): Int {
+            val x = a.personalityTraits
+            val y = b.personalityTraits
+            var score = 0
+            score += maxOf(0, 40 - abs(x.introvertExtrovert - y.introvertExtrovert) * 12)
+            score += if (x.conflictResolution == y.conflictResolution) 30 else 15
+            score += maxOf(0, 30 - abs(x.adaptability - y.adaptability) * 8)
+            return score
+        }
+        
+        private fun minutesApart(time1: String, time2: String): Int =
+            abs(SurveyFeatureMatrix.parseTime(time1) - SurveyFeatureMatrix.parseTime(time2))
+    }
+    
+    companion object {
+        private const val SEED = 2024
+        
+        /**
+         * [count] surveys with answers drawn from small pools, so both
+         * matches and mismatches of every term come up.
+         */
+        fun randomSurveys(random: Random, count: Int, dealBreakers: List<String> = emptyList()): List<RoommateSurvey> =
+            List(count) { i ->
+                RoommateSurvey(
+                    id = "survey-$i",
+                    studentId = "student-$i",
+                    lifestyle = LifestylePreferences(
+                        sleepTime = randomTime(random),
+                        wakeTime = randomTime(random),
+                        foodPreference = FoodPreference.values().random(random),
+                        smokingHabit = random.nextInt(4) == 0,
+                        drinkingHabit = random.nextInt(3) == 0
+                    ),
+                    studyHabits = StudyHabits(
+                        studyStyle = StudyStyle.values().random(random),
+                        preferredStudyTime = listOf("morning", "evening", "night").random(random),
+                        needsQuietEnvironment = random.nextBoolean(),
+                        musicWhileStudying = random.nextBoolean()
+                    ),
+                    cleanliness = CleanlinessPreferences(
+                        cleaningFrequency = listOf("daily", "weekly", "monthly").random(random),
+                        organizationLevel = random.nextInt(1, 6),
+                        sharedItemsComfort = random.nextInt(1, 6)
+                    ),
+                    socialPreferences = SocialPreferences(
+                        visitorFrequency = listOf("never", "sometimes", "often").random(random),
+                        partyAttitude = listOf("avoid", "occasional", "love").random(random),
+                        privacyNeeds = random.nextInt(1, 6)
+                    ),
+                    sleepSchedule = SleepSchedule(
+                        typicalBedtime = randomTime(random),
+                        typicalWakeTime = randomTime(random),
+                        sleepSensitivity = listOf("light", "moderate", "heavy").random(random)
+                    ),
+                    personalityTraits = PersonalityTraits(
+                        introvertExtrovert = random.nextInt(1, 6),
+                        conflictResolution = listOf("discuss", "avoid", "compromise").random(random),
+                        adaptability = random.nextInt(1, 6)
+                    ),
+                    dealBreakers = dealBreakers.filter { random.nextInt(6) == 0 },
+                    updatedAt = i.toLong()
+                )
+            }
+        
+        private fun randomTime(random: Random): String {
+            val hour = random.nextInt(1, 13)
+            val minute = random.nextInt(4) * 15
+            val half = if (random.nextBoolean()) "AM" else "PM"
+            return "$hour:${minute.toString().padStart(2, '0')} $half"
+        }
+    }
+}
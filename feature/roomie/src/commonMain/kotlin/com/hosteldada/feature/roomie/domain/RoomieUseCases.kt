@@ -1,16 +1,38 @@
 package com.hosteldada.feature.roomie.domain
 
+import com.hosteldada.core.common.DispatcherProvider
 import com.hosteldada.core.common.Result
 import com.hosteldada.core.domain.model.*
 import com.hosteldada.core.domain.repository.*
+import com.hosteldada.core.domain.algorithm.CompatibilityBatchEngine
 import com.hosteldada.core.domain.algorithm.CompatibilityGraph
+import com.hosteldada.core.domain.algorithm.CompatibilityProgress
+import com.hosteldada.core.domain.algorithm.ConstraintIndex
+import com.hosteldada.core.domain.algorithm.PartitionFallback
+import com.hosteldada.core.domain.algorithm.PartitionKey
+import com.hosteldada.core.domain.algorithm.ScoringPlan
+import com.hosteldada.core.domain.algorithm.SurveyFeatureMatrix
+import com.hosteldada.core.domain.algorithm.SurveyPartitions
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Semaphore
+import kotlinx.coroutines.sync.withPermit
 
 /**
  * Use case for submitting roommate survey
+ * Updating an existing survey queues that student's compatibility row
+ * for background recomputation
  */
 class SubmitSurveyUseCase(
     private val surveyRepository: SurveyRepository,
-    private val profileRepository: ProfileRepository
+    private val profileRepository: ProfileRepository,
+    private val rowUpdater: CompatibilityRowUpdater? = null
 ) {
     suspend operator fun invoke(survey: RoommateSurvey): Result<String> {
         // Validate survey completion
@@ -30,13 +52,18 @@ class SubmitSurveyUseCase(
             survey.semester
         )
         
+        // Version the survey so stored compatibility scores can detect staleness
+        val versioned = survey.copy(updatedAt = System.currentTimeMillis())
+        
         return if (existing != null) {
             // Update existing survey
-            surveyRepository.updateSurvey(survey.copy(id = existing.id))
+            val result = surveyRepository.updateSurvey(versioned.copy(id = existing.id))
+            if (result is Result.Error) return result
+            rowUpdater?.markDirty(survey.studentId, survey.semester)
             Result.Success(existing.id)
         } else {
             // Create new survey
-            surveyRepository.createSurvey(survey)
+            surveyRepository.createSurvey(versioned)
         }
     }
 }
@@ -59,97 +86,143 @@ class GetSurveyUseCase(
 
 /**
  * Use case for calculating compatibility between two students
- * Uses weighted graph algorithm
+ * A stored score is returned while it matches both surveys and the
+ * semester's scoring profile; otherwise the pair is rescored with that
+ * profile and saved over it. Pairs ruled out by a deal-breaker are never
+ * stored, as in the batch path
+ * Time complexity: O(1) scoring
  */
 class CalculateCompatibilityUseCase(
     private val compatibilityRepository: CompatibilityRepository,
-    private val surveyRepository: SurveyRepository
+    private val surveyRepository: SurveyRepository,
+    private val scoringProfileRepository: ScoringProfileRepository? = null
 ) {
-    private val graph = CompatibilityGraph()
-    
     suspend operator fun invoke(
         studentId1: String, 
         studentId2: String,
         semester: String
     ): Result<CompatibilityScore> {
-        // Check if already calculated
-        val existing = compatibilityRepository.getCompatibility(studentId1, studentId2)
-        if (existing != null) {
-            return Result.Success(existing)
+        return try {
+            // Get surveys
+            val survey1 = surveyRepository.getSurveyByStudentAndSemester(studentId1, semester)
+                ?: return Result.Error("Survey not found for student $studentId1")
+            val survey2 = surveyRepository.getSurveyByStudentAndSemester(studentId2, semester)
+                ?: return Result.Error("Survey not found for student $studentId2")
+            
+            val graph = CompatibilityGraph(scoringProfileRepository.profileFor(semester))
+            graph.addStudent(studentId1, survey1)
+            graph.addStudent(studentId2, survey2)
+            
+            // Reuse the stored score unless a survey or the profile changed since
+            val existing = compatibilityRepository.getCompatibility(studentId1, studentId2)
+            if (existing != null && graph.isCurrent(existing)) {
+                return Result.Success(existing)
+            }
+            
+            if (!graph.isCompatible(studentId1, studentId2)) {
+                existing?.let { compatibilityRepository.deleteCompatibility(it.studentId1, it.studentId2) }
+                return Result.Error("A deal-breaker rules out this pair")
+            }
+            
+            val score = graph.calculateEdge(studentId1, studentId2)
+                ?: return Result.Error("Failed to calculate compatibility")
+            
+            // Save over the stored score and return
+            val result = compatibilityRepository.saveCompatibility(score.orientedLike(existing))
+            if (result is Result.Error) return result
+            Result.Success(score)
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Result.Error("Failed to calculate compatibility: ${e.message}", e)
         }
-        
-        // Get surveys
-        val survey1 = surveyRepository.getSurveyByStudentAndSemester(studentId1, semester)
-            ?: return Result.Error("Survey not found for student $studentId1")
-        val survey2 = surveyRepository.getSurveyByStudentAndSemester(studentId2, semester)
-            ?: return Result.Error("Survey not found for student $studentId2")
-        
-        // Calculate using graph algorithm
-        val score = graph.calculateCompatibility(survey1, survey2)
-        
-        // Save and return
-        compatibilityRepository.saveCompatibility(score)
-        return Result.Success(score)
     }
 }
 
 /**
  * Use case for getting top matches for a student
- * Time complexity: O(n log n) where n is number of surveys
+ * Only students in the same partition (gender, year, hostel block) are
+ * candidates; a [PartitionFallback] tops up a short list from a wider one
+ * Candidates stream through a bounded heap; only the winners are built
+ * into full scores
+ * Time complexity: O(m log k) where m is the size of the student's partition
  */
 class GetTopMatchesUseCase(
     private val compatibilityRepository: CompatibilityRepository,
-    private val surveyRepository: SurveyRepository
+    private val surveyRepository: SurveyRepository,
+    private val scoringProfileRepository: ScoringProfileRepository? = null,
+    private val studentRepository: StudentRepository? = null
 ) {
-    private val graph = CompatibilityGraph()
-    
     suspend operator fun invoke(
         studentId: String,
         semester: String,
-        limit: Int = 10
+        limit: Int = 10,
+        fallback: PartitionFallback = PartitionFallback.NONE
     ): Result<List<CompatibilityScore>> {
         return try {
             // Get all surveys for semester
             val allSurveys = surveyRepository.getSurveysBySemester(semester)
-            val studentSurvey = allSurveys.find { it.studentId == studentId }
-                ?: return Result.Error("Survey not found for student")
-            
-            // Build graph with all students
-            allSurveys.forEach { survey ->
-                graph.addStudent(survey.studentId)
+            if (allSurveys.none { it.studentId == studentId }) {
+                return Result.Error("Survey not found for student")
             }
             
-            // Calculate all compatibilities for this student
-            val scores = mutableListOf<CompatibilityScore>()
-            allSurveys.filter { it.studentId != studentId }.forEach { otherSurvey ->
-                val score = graph.calculateCompatibility(studentSurvey, otherSurvey)
-                scores.add(score)
-            }
+            // Group by gender, year and hostel block
+            val profile = scoringProfileRepository.profileFor(semester)
+            val keys = studentRepository.partitionKeys()
+            val partitions = SurveyPartitions(allSurveys) { keys[it] ?: PartitionKey.UNKNOWN }
             
-            // Sort by overall score and take top N
-            val topMatches = scores
-                .sortedByDescending { it.overallScore }
-                .take(limit)
+            // Build graph with the student's partition only
+            val matches = topMatches(partitions, studentId, profile, limit)
+            if (matches.size >= limit || fallback == PartitionFallback.NONE) {
+                return Result.Success(matches)
+            }
             
-            Result.Success(topMatches)
+            // Fill the rest from the wider partition
+            val matched = matches.mapTo(hashSetOf(studentId)) { it.studentId2 }
+            val wider = topMatches(partitions.widen(fallback), studentId, profile, limit)
+                .filter { it.studentId2 !in matched }
+            Result.Success(matches + wider.take(limit - matches.size))
         } catch (e: Exception) {
             Result.Error("Failed to calculate matches: ${e.message}", e)
         }
     }
+    
+    private fun topMatches(
+        partitions: SurveyPartitions,
+        studentId: String,
+        profile: ScoringProfile,
+        limit: Int
+    ): List<CompatibilityScore> {
+        val partition = partitions.partitionOf(studentId) ?: return emptyList()
+        val graph = CompatibilityGraph(profile)
+        partition.surveys.forEach { survey ->
+            graph.addStudent(survey.studentId, survey)
+        }
+        return graph.getTopMatches(studentId, limit)
+    }
 }
 
 /**
  * Use case for generating all compatibilities for a semester
  * Used by admin for batch processing
- * Time complexity: O(n²) where n is number of surveys
+ * Only pairs within a partition (gender, year, hostel block) are scored,
+ * in parallel tiles on the default dispatcher, and saved by a separate
+ * stage as tiles complete, up to [MAX_CONCURRENT_WRITES] writes at a time
+ * Time complexity: O(Σ nᵢ²) over partition sizes nᵢ, split across cores
  */
 class GenerateAllCompatibilitiesUseCase(
     private val compatibilityRepository: CompatibilityRepository,
-    private val surveyRepository: SurveyRepository
+    private val surveyRepository: SurveyRepository,
+    dispatcherProvider: DispatcherProvider,
+    private val scoringProfileRepository: ScoringProfileRepository? = null,
+    private val studentRepository: StudentRepository? = null
 ) {
-    private val graph = CompatibilityGraph()
+    private val engine = CompatibilityBatchEngine(dispatcherProvider.default)
     
-    suspend operator fun invoke(semester: String): Result<Int> {
+    suspend operator fun invoke(
+        semester: String,
+        onProgress: (CompatibilityProgress) -> Unit = {}
+    ): Result<Int> {
         return try {
             val surveys = surveyRepository.getSurveysBySemester(semester)
             
@@ -157,22 +230,152 @@ class GenerateAllCompatibilitiesUseCase(
                 return Result.Error("Need at least 2 surveys to calculate compatibility")
             }
             
-            var count = 0
-            
-            // Generate all pairs O(n²)
-            for (i in surveys.indices) {
-                for (j in i + 1 until surveys.size) {
-                    val score = graph.calculateCompatibility(surveys[i], surveys[j])
-                    compatibilityRepository.saveCompatibility(score)
-                    count++
-                }
+            val profile = scoringProfileRepository.profileFor(semester)
+            val keys = studentRepository.partitionKeys()
+            val partitions = SurveyPartitions(surveys) { keys[it] ?: PartitionKey.UNKNOWN }
+            val count = engine.generatePartitioned(
+                partitions.partitions.map { it.surveys }, ScoringPlan.of(profile), profile.updatedAt, onProgress
+            ) { batch ->
+                saveAll(batch)
             }
             
-            Result.Success(count)
+            Result.Success(count.toInt())
+        } catch (e: CancellationException) {
+            throw e
         } catch (e: Exception) {
             Result.Error("Failed to generate compatibilities: ${e.message}", e)
         }
     }
+    
+    /**
+     * Save a tile's scores with their round trips overlapping, bounded so
+     * a 64 x 64 tile doesn't open thousands of requests at once.
+     */
+    private suspend fun saveAll(scores: List<CompatibilityScore>) {
+        val writes = Semaphore(MAX_CONCURRENT_WRITES)
+        coroutineScope {
+            scores.map { score ->
+                async { writes.withPermit { compatibilityRepository.saveCompatibility(score) } }
+            }.awaitAll()
+        }
+    }
+    
+    private companion object {
+        const val MAX_CONCURRENT_WRITES = 16
+    }
+}
+
+/**
+ * Background recomputation of compatibility rows after survey updates
+ * Updates are queued and coalesced; a single worker rescores only the
+ * updated students' rows within their partition (gender, year, hostel
+ * block), the same pairs the batch path scores, writes just the edges
+ * whose survey or profile versions changed to the local and remote stores,
+ * and deletes stored edges the row no longer holds
+ * Time complexity: O(m) per updated student, m the size of their partition
+ */
+class CompatibilityRowUpdater(
+    private val compatibilityRepository: CompatibilityRepository,
+    private val surveyRepository: SurveyRepository,
+    dispatcherProvider: DispatcherProvider,
+    private val scoringProfileRepository: ScoringProfileRepository? = null,
+    private val studentRepository: StudentRepository? = null
+) {
+    private val scope = CoroutineScope(SupervisorJob() + dispatcherProvider.default)
+    
+    // (studentId, semester) of updated surveys
+    private val updates = Channel<Pair<String, String>>(Channel.UNLIMITED)
+    
+    // One graph per (semester, partition); only the worker touches these
+    private val graphs = mutableMapOf<Pair<String, PartitionKey>, PartitionGraph>()
+    
+    init {
+        scope.launch {
+            for (first in updates) {
+                // Coalesce updates queued while the previous batch ran
+                val batch = linkedSetOf(first)
+                while (true) batch.add(updates.tryReceive().getOrNull() ?: break)
+                
+                batch.forEach { (studentId, semester) ->
+                    try {
+                        refreshRow(studentId, semester)
+                    } catch (e: CancellationException) {
+                        throw e
+                    } catch (e: Exception) {
+                        // Stale edges keep their old versions and are rewritten on the next update
+                    }
+                }
+            }
+        }
+    }
+    
+    /**
+     * Queue [studentId]'s row in [semester] for recomputation.
+     */
+    fun markDirty(studentId: String, semester: String) {
+        updates.trySend(studentId to semester)
+    }
+    
+    private suspend fun refreshRow(studentId: String, semester: String) {
+        val profile = scoringProfileRepository.profileFor(semester)
+        val keys = studentRepository.partitionKeys()
+        val partitions = SurveyPartitions(surveyRepository.getSurveysBySemester(semester)) {
+            keys[it] ?: PartitionKey.UNKNOWN
+        }
+        val partition = partitions.partitionOf(studentId) ?: return
+        
+        // Rebuild when the profile or the partition's students changed
+        val studentIds = partition.surveys.mapTo(hashSetOf()) { it.studentId }
+        val cached = graphs[semester to partition.key]
+        val current = if (cached != null && cached.profile == profile && cached.studentIds == studentIds) {
+            cached
+        } else {
+            PartitionGraph(profile, studentIds).also { graphs[semester to partition.key] = it }
+        }
+        partition.surveys.forEach { survey ->
+            current.graph.addStudent(survey.studentId, survey)
+        }
+        
+        // Also picks up other students whose newer surveys the graph just saw
+        (listOf(studentId) + current.graph.dirtyStudents()).distinct().forEach { dirtyId ->
+            persistRow(current.graph, dirtyId)
+        }
+    }
+    
+    /**
+     * Save the row's edges that are missing or computed from older surveys
+     * or another profile, and delete stored edges to students the row no
+     * longer pairs with, e.g. after a new deal-breaker or a move to another
+     * partition. Returns the number of edges written or deleted.
+     */
+    private suspend fun persistRow(graph: CompatibilityGraph, studentId: String): Int {
+        val stored = compatibilityRepository.getCompatibilitiesForStudent(studentId)
+            .associateBy { if (it.studentId1 == studentId) it.studentId2 else it.studentId1 }
+        val row = graph.recomputeRow(studentId)
+        
+        var written = 0
+        row.forEach { score ->
+            val previous = stored[score.studentId2]
+            if (previous != null && graph.isCurrent(previous)) return@forEach
+            
+            val result = compatibilityRepository.saveCompatibility(score.orientedLike(previous))
+            if (result is Result.Success) written++
+        }
+        
+        val paired = row.mapTo(hashSetOf()) { it.studentId2 }
+        stored.forEach { (otherId, previous) ->
+            if (otherId in paired) return@forEach
+            
+            val result = compatibilityRepository.deleteCompatibility(previous.studentId1, previous.studentId2)
+            if (result is Result.Success) written++
+        }
+        return written
+    }
+    
+    // Graph over one partition's students, scored with [profile]
+    private class PartitionGraph(val profile: ScoringProfile, val studentIds: Set<String>) {
+        val graph = CompatibilityGraph(profile)
+    }
 }
 
 /**
@@ -240,17 +443,26 @@ class CreateAssignmentUseCase(
 
 /**
  * Use case for auto-assigning students using greedy algorithm
- * Time complexity: O(n² log n) where n is number of students
+ * Students are only paired within their partition (gender, year, hostel
+ * block) and housed in rooms of that block; partitions are ranked in
+ * parallel. A [PartitionFallback] pairs the students left over across
+ * wider partitions
+ * Pairs ruled out by deal-breakers never reach scoring or sorting
+ * Time complexity: O(p log p) for p compatible pairs, at most Σ nᵢ²/2
  */
 class AutoAssignStudentsUseCase(
     private val surveyRepository: SurveyRepository,
     private val roomRepository: RoomRepository,
     private val assignmentRepository: AssignmentRepository,
-    private val compatibilityRepository: CompatibilityRepository
+    private val compatibilityRepository: CompatibilityRepository,
+    private val dispatcherProvider: DispatcherProvider,
+    private val scoringProfileRepository: ScoringProfileRepository? = null,
+    private val studentRepository: StudentRepository? = null
 ) {
-    private val graph = CompatibilityGraph()
-    
-    suspend operator fun invoke(semester: String): Result<List<RoomAssignment>> {
+    suspend operator fun invoke(
+        semester: String,
+        fallback: PartitionFallback = PartitionFallback.NONE
+    ): Result<List<RoomAssignment>> {
         return try {
             // Step 1: Get all surveys for semester
             val surveys = surveyRepository.getSurveysBySemester(semester)
@@ -267,29 +479,61 @@ class AutoAssignStudentsUseCase(
                 return Result.Error("No available rooms")
             }
             
-            // Step 3: Generate all compatibility scores O(n²)
-            val pairs = mutableListOf<Triple<String, String, CompatibilityScore>>()
-            for (i in surveys.indices) {
-                for (j in i + 1 until surveys.size) {
-                    val score = graph.calculateCompatibility(surveys[i], surveys[j])
-                    pairs.add(Triple(surveys[i].studentId, surveys[j].studentId, score))
-                }
-            }
-            
-            // Step 4: Sort by compatibility descending O(n² log n)
-            pairs.sortByDescending { it.third.overallScore }
+            // Step 3: Partition by gender, year and hostel block
+            val plan = ScoringPlan.of(scoringProfileRepository.profileFor(semester))
+            val keys = studentRepository.partitionKeys()
+            val partitions = SurveyPartitions(surveys) { keys[it] ?: PartitionKey.UNKNOWN }
             
-            // Step 5: Greedy assignment
+            // Step 4: Greedy assignment within partitions, then across wider ones
             val assigned = mutableSetOf<String>()
             val assignments = mutableListOf<RoomAssignment>()
-            var roomIndex = 0
+            assignPartitions(partitions, plan, rooms, semester, assigned, assignments)
+            
+            if (fallback != PartitionFallback.NONE) {
+                val leftover = surveys.filter { it.studentId !in assigned }
+                val wider = SurveyPartitions(leftover) { (keys[it] ?: PartitionKey.UNKNOWN).widen(fallback) }
+                assignPartitions(wider, plan, rooms, semester, assigned, assignments)
+            }
             
-            for ((student1, student2, score) in pairs) {
+            Result.Success(assignments)
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Result.Error("Auto-assignment failed: ${e.message}", e)
+        }
+    }
+    
+    /**
+     * Pair students of each partition, best pairs first, into free rooms of
+     * the partition's block. Pairs are ranked for all partitions in
+     * parallel; rooms are then handed out one partition at a time, and
+     * taken rooms are removed from [rooms].
+     */
+    private suspend fun assignPartitions(
+        partitions: SurveyPartitions,
+        plan: ScoringPlan,
+        rooms: MutableList<Room>,
+        semester: String,
+        assigned: MutableSet<String>,
+        assignments: MutableList<RoomAssignment>
+    ) {
+        val ranked = partitions.mapParallel(dispatcherProvider.default) { partition ->
+            rankCompatiblePairs(partition.surveys, plan)
+        }
+        
+        partitions.partitions.forEachIndexed { index, partition ->
+            val surveys = partition.surveys
+            for (pair in ranked[index]) {
+                val student1 = surveys[firstOf(pair)].studentId
+                val student2 = surveys[secondOf(pair)].studentId
+                val overallScore = scoreOf(pair)
+                
                 // Skip if either student already assigned
                 if (student1 in assigned || student2 in assigned) continue
                 
-                // Check if rooms available
-                if (roomIndex >= rooms.size) break
+                // Check if rooms available in this partition's block
+                val roomIndex = rooms.indexOfFirst { partition.key.admitsBlock(it.hostelBlock) }
+                if (roomIndex < 0) break
                 
                 val room = rooms[roomIndex]
                 
@@ -298,7 +542,7 @@ class AutoAssignStudentsUseCase(
                     id = generateAssignmentId(),
                     roomId = room.id,
                     studentIds = listOf(student1, student2),
-                    compatibilityScore = score.overallScore,
+                    compatibilityScore = overallScore,
                     semester = semester,
                     status = AssignmentStatus.PENDING_APPROVAL,
                     createdAt = System.currentTimeMillis()
@@ -310,19 +554,51 @@ class AutoAssignStudentsUseCase(
                     assignments.add(result.data)
                     assigned.add(student1)
                     assigned.add(student2)
-                    roomIndex++
+                    rooms.removeAt(roomIndex)
                 }
             }
-            
-            Result.Success(assignments)
-        } catch (e: Exception) {
-            Result.Error("Auto-assignment failed: ${e.message}", e)
         }
     }
     
     private fun generateAssignmentId(): String {
         return "ASSIGN_${System.currentTimeMillis()}"
     }
+    
+    /**
+     * Compatible pairs packed as (score, i, j), best score first and in
+     * survey order within a score.
+     * Time complexity: O(c n / 64 + n²) candidate generation, O(p log p) sort
+     */
+    private fun rankCompatiblePairs(surveys: List<RoommateSurvey>, plan: ScoringPlan): LongArray {
+        val features = SurveyFeatureMatrix(surveys.size, plan)
+        surveys.forEach { features.add(it) }
+        val constraints = ConstraintIndex(features)
+        
+        var pairs = LongArray(surveys.size)
+        var count = 0
+        for (i in surveys.indices) {
+            for (j in constraints.candidates(i, from = i + 1)) {
+                if (count == pairs.size) pairs = pairs.copyOf(pairs.size * 2)
+                // Rows are stored inverted so a descending sort keeps survey order on ties
+                pairs[count++] = (features.overallScore(i, j).toLong() shl SCORE_SHIFT) or
+                    ((ROW_MASK - i).toLong() shl ROW_BITS) or (ROW_MASK - j).toLong()
+            }
+        }
+        pairs = pairs.copyOf(count)
+        pairs.sortDescending()
+        return pairs
+    }
+    
+    private fun scoreOf(pair: Long): Int = (pair ushr SCORE_SHIFT).toInt()
+    private fun firstOf(pair: Long): Int = ROW_MASK - ((pair ushr ROW_BITS).toInt() and ROW_MASK)
+    private fun secondOf(pair: Long): Int = ROW_MASK - (pair.toInt() and ROW_MASK)
+    
+    private companion object {
+        // 21 bits per survey row, score above them
+        const val ROW_BITS = 21
+        const val ROW_MASK = (1 shl ROW_BITS) - 1
+        const val SCORE_SHIFT = 2 * ROW_BITS
+    }
 }
 
 /**
@@ -416,3 +692,66 @@ class ManageRoomUseCase(
         }
     }
 }
+
+/**
+ * Use case for admin to tune compatibility scoring per semester
+ * Saved profiles apply to scores computed afterwards; regenerate the
+ * semester's compatibilities to rescore stored ones
+ */
+class ManageScoringProfileUseCase(
+    private val scoringProfileRepository: ScoringProfileRepository
+) {
+    suspend fun getProfile(semester: String): Result<ScoringProfile> {
+        return try {
+            Result.Success(scoringProfileRepository.profileFor(semester).copy(semester = semester))
+        } catch (e: Exception) {
+            Result.Error("Failed to load scoring profile: ${e.message}", e)
+        }
+    }
+    
+    suspend fun saveProfile(profile: ScoringProfile): Result<Unit> {
+        return try {
+            // Rejects negative points or weights and non-positive steps
+            ScoringPlan.compile(profile)
+            scoringProfileRepository.saveProfile(profile.copy(updatedAt = System.currentTimeMillis()))
+        } catch (e: Exception) {
+            Result.Error("Failed to save scoring profile: ${e.message}", e)
+        }
+    }
+}
+
+/**
+ * Matching partition of every student by user id; empty when there is
+ * no repository or the students fail to load, which puts everyone in
+ * one partition.
+ */
+private suspend fun StudentRepository?.partitionKeys(): Map<String, PartitionKey> {
+    val result = this?.getAllStudents() ?: return emptyMap()
+    val students = (result as? Result.Success)?.data ?: return emptyMap()
+    return students.associate { it.userId to PartitionKey.of(it) }
+}
+
+/**
+ * Scoring profile of [semester], or the default one when none is saved,
+ * it fails to load, or there is no repository.
+ */
+private suspend fun ScoringProfileRepository?.profileFor(semester: String): ScoringProfile {
+    val result = this?.getProfile(semester) ?: return ScoringProfile.DEFAULT
+    return (result as? Result.Success)?.data ?: ScoringProfile.DEFAULT
+}
+
+/**
+ * This score with the id and student order of [previous], the stored
+ * score of the same pair, so saving it overwrites that document.
+ */
+private fun CompatibilityScore.orientedLike(previous: CompatibilityScore?): CompatibilityScore = when {
+    previous == null -> this
+    previous.studentId1 == studentId1 -> copy(id = previous.id)
+    else -> copy(
+        id = previous.id,
+        studentId1 = studentId2,
+        studentId2 = studentId1,
+        survey1Version = survey2Version,
+        survey2Version = survey1Version
+    )
+}
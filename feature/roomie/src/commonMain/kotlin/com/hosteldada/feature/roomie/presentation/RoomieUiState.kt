@@ -1,5 +1,6 @@
 package com.hosteldada.feature.roomie.presentation
 
+import com.hosteldada.core.domain.algorithm.CompatibilityProgress
 import com.hosteldada.core.domain.model.*
 
 /**
@@ -237,6 +238,7 @@ data class RoomieAdminUiState(
     
     // Statistics
     val stats: RoomieStats = RoomieStats(),
+    val compatibilityProgress: CompatibilityProgress? = null, // non-null while generating
     
     // Messages
     val errorMessage: String? = null,
@@ -379,6 +381,7 @@ sealed class RoomieAdminIntent {
     // Statistics
     object RefreshStats : RoomieAdminIntent()
     object GenerateAllCompatibilities : RoomieAdminIntent()
+    object CancelCompatibilityGeneration : RoomieAdminIntent()
     
     // Messages
     object ClearError : RoomieAdminIntent()
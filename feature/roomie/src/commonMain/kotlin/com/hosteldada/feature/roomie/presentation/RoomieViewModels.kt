@@ -1,6 +1,7 @@
 package com.hosteldada.feature.roomie.presentation
 
 import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
@@ -8,6 +9,7 @@ import kotlinx.coroutines.flow.update
 import kotlinx.coroutines.launch
 import com.hosteldada.core.common.DispatcherProvider
 import com.hosteldada.core.common.Result
+import com.hosteldada.core.domain.algorithm.CompatibilityProgress
 import com.hosteldada.core.domain.model.*
 import com.hosteldada.feature.roomie.domain.*
 
@@ -343,6 +345,8 @@ class RoomieAdminViewModel(
     private val _state = MutableStateFlow(RoomieAdminUiState())
     val state: StateFlow<RoomieAdminUiState> = _state.asStateFlow()
     
+    private var generationJob: Job? = null
+    
     fun handleIntent(intent: RoomieAdminIntent) {
         when (intent) {
             // Tab navigation
@@ -372,6 +376,7 @@ class RoomieAdminViewModel(
             // Statistics
             is RoomieAdminIntent.RefreshStats -> refreshStats()
             is RoomieAdminIntent.GenerateAllCompatibilities -> generateAllCompatibilities()
+            is RoomieAdminIntent.CancelCompatibilityGeneration -> cancelCompatibilityGeneration()
             
             // Messages
             is RoomieAdminIntent.ClearError -> _state.update { it.copy(errorMessage = null) }
@@ -588,15 +593,20 @@ class RoomieAdminViewModel(
     }
     
     private fun generateAllCompatibilities() {
-        coroutineScope.launch(dispatcherProvider.io) {
-            _state.update { it.copy(isLoading = true) }
+        if (generationJob?.isActive == true) return
+        generationJob = coroutineScope.launch(dispatcherProvider.io) {
+            _state.update { it.copy(isLoading = true, compatibilityProgress = CompatibilityProgress()) }
             
             val semester = _state.value.selectedSemester
-            when (val result = generateAllCompatibilitiesUseCase(semester)) {
+            val result = generateAllCompatibilitiesUseCase(semester) { progress ->
+                _state.update { it.copy(compatibilityProgress = progress) }
+            }
+            when (result) {
                 is Result.Success -> {
                     _state.update { 
                         it.copy(
                             isLoading = false,
+                            compatibilityProgress = null,
                             successMessage = "Generated ${result.data} compatibility scores"
                         )
                     }
@@ -605,6 +615,7 @@ class RoomieAdminViewModel(
                     _state.update { 
                         it.copy(
                             isLoading = false,
+                            compatibilityProgress = null,
                             errorMessage = result.message
                         )
                     }
@@ -612,6 +623,12 @@ class RoomieAdminViewModel(
             }
         }
     }
+    
+    private fun cancelCompatibilityGeneration() {
+        generationJob?.cancel()
+        generationJob = null
+        _state.update { it.copy(isLoading = false, compatibilityProgress = null) }
+    }
 }
 
 // Extension functions to convert domain models to form states and vice versa
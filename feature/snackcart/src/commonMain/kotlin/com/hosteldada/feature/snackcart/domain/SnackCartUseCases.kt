@@ -1,9 +1,22 @@
 package com.hosteldada.feature.snackcart.domain
 
 import com.hosteldada.core.common.result.Result
+import com.hosteldada.core.common.telemetry.SearchTelemetry
+import com.hosteldada.core.common.telemetry.SearchTelemetryReport
+import com.hosteldada.core.domain.algorithm.SnackCatalogDiff
+import com.hosteldada.core.domain.algorithm.SnackFacetCounts
+import com.hosteldada.core.domain.algorithm.SnackFacetIndex
+import com.hosteldada.core.domain.algorithm.SnackFacetSelection
+import com.hosteldada.core.domain.algorithm.SnackRanking
+import com.hosteldada.core.domain.algorithm.SnackRelevanceIndex
+import com.hosteldada.core.domain.algorithm.SnackSearchTrie
+import com.hosteldada.core.domain.algorithm.SnackTrigramIndex
 import com.hosteldada.core.domain.model.*
 import com.hosteldada.core.domain.repository.*
 import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlin.time.TimeSource
 
 /**
  * ============================================
@@ -32,20 +45,218 @@ class GetSnacksByCategoryUseCase(
 }
 
 class SearchSnacksUseCase(
-    private val snackRepository: SnackRepository
+    private val snackRepository: SnackRepository,
+    private val searchIndex: SnackSearchTrie = SnackSearchTrie(),
+    private val substringIndex: SnackTrigramIndex = SnackTrigramIndex(),
+    private val relevanceIndex: SnackRelevanceIndex = SnackRelevanceIndex(),
+    private val telemetry: SearchTelemetry? = null
 ) {
+    // Type-ahead queries extend or trim the previous one, so keep one session;
+    // sessions are not thread-safe and keystroke searches may overlap
+    private val session = searchIndex.openSession()
+    private val sessionLock = Mutex()
+    
+    // Content version last restored or written; persisting is skipped until it moves
+    private var persistedVersion = NOT_PERSISTED
+    private val persistLock = Mutex()
+    
     /**
-     * Search snacks using Trie-based search.
-     * Time: O(k) where k is query length.
+     * Search snacks using Trie-based search, followed by substring matches
+     * the prefix search misses ("chips" -> "Potato Chips"), then typo and
+     * sound-alike matches while results are thin.
+     * [SearchMode.RELEVANCE] instead returns the BM25 top results.
+     * Falls back to the repository until the catalog has been indexed.
+     * Time: O(d) per keystroke where d is the number of changed chars,
+     * plus the trigram lookup.
      */
-    suspend operator fun invoke(query: String): Result<List<Snack>> {
+    suspend operator fun invoke(query: String, mode: SearchMode = SearchMode.TYPE_AHEAD): Result<List<Snack>> {
+        if (telemetry == null || query.isBlank()) return search(query, mode)
+        
+        val started = TimeSource.Monotonic.markNow()
+        val result = search(query, mode)
+        if (result is Result.Success) {
+            telemetry.record(
+                query = query,
+                normalized = SnackSearchTrie.normalize(query),
+                resultCount = result.data.size,
+                indexVersion = searchIndex.getVersion(),
+                latencyNanos = started.elapsedNow().inWholeNanoseconds
+            )
+        }
+        return result
+    }
+    
+    private suspend fun search(query: String, mode: SearchMode): Result<List<Snack>> {
         if (query.isBlank()) {
             return snackRepository.getAllSnacks()
         }
-        return snackRepository.searchSnacks(query)
+        if (mode == SearchMode.RELEVANCE && relevanceIndex.getSize() > 0) {
+            // "spicy", "protein": BM25 over name, tags and description
+            return Result.Success(relevanceIndex.search(query))
+        }
+        if (searchIndex.getSize() == 0) {
+            return snackRepository.searchSnacks(query)
+        }
+        // "cold coffee", "maggi masala": match terms in any order and field
+        if (SnackSearchTrie.parseTerms(query).size > 1) {
+            return Result.Success(withNearMatches(query, searchIndex.searchTerms(query, limit = Int.MAX_VALUE)))
+        }
+        val prefixMatches = sessionLock.withLock {
+            session.setQuery(query.trimStart())
+            session.allResults()
+        }
+        
+        val seen = prefixMatches.mapTo(HashSet()) { it.id }
+        val infixMatches = substringIndex.search(query).filter { it.id !in seen }
+        return Result.Success(withNearMatches(query, prefixMatches + infixMatches))
+    }
+    
+    // Only when exact spellings are thin: typos ("magi", "smaosa") by edit
+    // distance first, then sound-alikes ("samossa", "kachauri")
+    private fun withNearMatches(query: String, matches: List<Snack>): List<Snack> {
+        if (matches.size >= THIN_RESULTS) return matches
+        
+        val seen = matches.mapTo(HashSet()) { it.id }
+        val withTypos = matches + searchIndex.searchFuzzy(query).filter { seen.add(it.id) }
+        if (withTypos.size >= THIN_RESULTS) return withTypos
+        
+        return withTypos + searchIndex.searchPhonetic(query).filter { seen.add(it.id) }
+    }
+    
+    /**
+     * Sync the search indexes with the latest catalog, given its [diff]
+     * from the catalog indexed last. Availability and stock flips only
+     * patch the trie's flag bits and the trigram and BM25 indexes' snacks;
+     * BM25 statistics are recomputed only when name, tags or description
+     * changed.
+     * Time: O(c n / 64) for flag flips, O(n) comparisons + O(changed words)
+     * for the trie otherwise
+     */
+    fun index(snacks: List<Snack>, diff: SnackCatalogDiff) {
+        if (diff.isEmpty) return
+        
+        if (diff.isFlagOnly) {
+            diff.changed.forEach { change ->
+                if (change.new.isAvailable != change.old.isAvailable) {
+                    searchIndex.setAvailability(change.new.id, change.new.isAvailable)
+                }
+                if (change.new.stockQuantity != change.old.stockQuantity) {
+                    searchIndex.setStockQuantity(change.new.id, change.new.stockQuantity)
+                }
+            }
+        } else {
+            searchIndex.applySnapshot(snacks)
+        }
+        substringIndex.applyDiff(snacks, diff)
+        relevanceIndex.applyDiff(snacks, diff)
+    }
+    
+    /**
+     * Rank results, top lists and completion weights by [ranking], e.g.
+     * popularity from [GetSnackRankingUseCase]. Unchanged rankings are skipped.
+     * Time: O(P K) to re-rank the trie, O(n log n + L) per rebuilt index
+     */
+    fun setRanking(ranking: SnackRanking) {
+        searchIndex.setRanking(ranking)
+        substringIndex.setRanking(ranking)
+        relevanceIndex.setRanking(ranking)
+    }
+    
+    /**
+     * Count a snack picked from search results towards autocomplete ranking.
+     */
+    fun recordSelection(query: String, snack: Snack) {
+        if (query.isNotBlank()) searchIndex.recordSelection(query, snack)
+    }
+    
+    /**
+     * Autocomplete words for the current query, most picked and ordered first.
+     */
+    fun suggestions(query: String, limit: Int = 10): List<String> =
+        searchIndex.getSuggestions(query.trimStart(), limit)
+    
+    /**
+     * Load the index persisted after the last sync, so search works before
+     * the catalog is fetched. Returns false if there is none or it is stale.
+     * Time: O(n + P), no sorting or re-ranking
+     */
+    suspend fun restoreIndex(): Boolean = persistLock.withLock {
+        val bytes = snackRepository.loadSearchIndex() ?: return@withLock false
+        val restored = searchIndex.restoreBinary(bytes)
+        if (restored) persistedVersion = searchIndex.getContentVersion()
+        restored
+    }
+    
+    /**
+     * Persist the current index for the next cold start, unless nothing
+     * but availability or stock changed since it was last restored or
+     * written; the next catalog sync refreshes those anyway.
+     * Returns true if the index was written.
+     */
+    suspend fun persistIndex(): Boolean = persistLock.withLock {
+        if (searchIndex.getSize() == 0) return@withLock false
+        
+        searchIndex.flushSelections()
+        val version = searchIndex.getContentVersion()
+        if (version == persistedVersion) return@withLock false
+        
+        snackRepository.saveSearchIndex(searchIndex.writeBinary())
+        persistedVersion = version
+        true
+    }
+    
+    private companion object {
+        const val THIN_RESULTS = 3
+        const val NOT_PERSISTED = -1
     }
 }
 
+class FilterSnacksUseCase(
+    private val facetIndex: SnackFacetIndex = SnackFacetIndex()
+) {
+    /**
+     * Snacks matching [selection], resolved from facet bitmaps with no I/O.
+     * With [within] (e.g. search results) their order is kept, and they
+     * pass through unfiltered until the catalog has been indexed.
+     * Time: O(f c + r) bitmap operations
+     */
+    operator fun invoke(selection: SnackFacetSelection, within: List<Snack>? = null): List<Snack> {
+        if (within != null && facetIndex.getSize() == 0) return within
+        return facetIndex.select(selection, within)
+    }
+    
+    /**
+     * Per-chip result counts for [selection].
+     */
+    fun counts(selection: SnackFacetSelection, within: List<Snack>? = null): SnackFacetCounts =
+        facetIndex.counts(selection, within)
+    
+    /**
+     * Sync facet bitmaps with the latest catalog, given its [diff] from the
+     * catalog indexed last. Changes that keep every snack's rank patch the
+     * changed ordinals' bits; anything else rebuilds.
+     * Time: O(n + c log c) patched, O(n log n) rebuilt
+     */
+    fun index(snacks: List<Snack>, diff: SnackCatalogDiff) = facetIndex.applyDiff(snacks, diff)
+    
+    /**
+     * List snacks in [ranking] order; see [SearchSnacksUseCase.setRanking].
+     * Time: O(n log n)
+     */
+    fun setRanking(ranking: SnackRanking) = facetIndex.setRanking(ranking)
+}
+
+/**
+ * How [SearchSnacksUseCase] matches a query.
+ */
+enum class SearchMode {
+    /** Prefix and substring matches on name, tags and category, by popularity */
+    TYPE_AHEAD,
+    
+    /** BM25 relevance over name, tags and description, best first */
+    RELEVANCE
+}
+
 class ObserveSnacksUseCase(
     private val snackRepository: SnackRepository
 ) {
@@ -254,6 +465,22 @@ class GetAllOrdersUseCase(
     }
 }
 
+/**
+ * Popularity ranking for search and menu order: units sold per snack
+ * over delivered order history.
+ */
+class GetSnackRankingUseCase(
+    private val orderRepository: OrderRepository
+) {
+    suspend operator fun invoke(): Result<SnackRanking> {
+        return when (val result = orderRepository.getAllOrders()) {
+            is Result.Success -> Result.Success(SnackRanking.fromOrders(result.data))
+            is Result.Error -> result
+            is Result.Loading -> Result.Loading
+        }
+    }
+}
+
 class UpdateOrderStatusUseCase(
     private val orderRepository: OrderRepository
 ) {
@@ -262,8 +489,24 @@ class UpdateOrderStatusUseCase(
     }
 }
 
+/**
+ * Search latency percentiles and zero-result queries for the admin stats screen.
+ */
+class GetSearchTelemetryUseCase(
+    private val telemetry: SearchTelemetry
+) {
+    operator fun invoke(zeroResultLimit: Int = SearchTelemetry.DEFAULT_ZERO_RESULT_LIMIT): SearchTelemetryReport =
+        telemetry.report(zeroResultLimit)
+    
+    /**
+     * Recent searches as CSV for export.
+     */
+    fun exportCsv(): String = telemetry.exportCsv()
+}
+
 class GetSnackStatsUseCase(
-    private val orderRepository: OrderRepository
+    private val orderRepository: OrderRepository,
+    private val getSearchTelemetry: GetSearchTelemetryUseCase? = null
 ) {
     suspend operator fun invoke(): Result<SnackStats> {
         return when (val result = orderRepository.getAllOrders()) {
@@ -290,7 +533,8 @@ class GetSnackStatsUseCase(
                     totalOrders = orders.size,
                     completedOrders = completed.size,
                     totalRevenue = totalRevenue,
-                    topSellers = topSellers
+                    topSellers = topSellers,
+                    search = getSearchTelemetry?.invoke() ?: SearchTelemetryReport.EMPTY
                 ))
             }
             is Result.Error -> result
@@ -303,7 +547,10 @@ data class SnackStats(
     val totalOrders: Int,
     val completedOrders: Int,
     val totalRevenue: Double,
-    val topSellers: List<TopSellerInfo>
+    val topSellers: List<TopSellerInfo>,
+    
+    // Search latency percentiles and zero-result queries
+    val search: SearchTelemetryReport = SearchTelemetryReport.EMPTY
 )
 
 data class TopSellerInfo(
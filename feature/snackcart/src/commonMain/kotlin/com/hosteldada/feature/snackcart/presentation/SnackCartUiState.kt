@@ -1,6 +1,9 @@
 package com.hosteldada.feature.snackcart.presentation
 
+import com.hosteldada.core.domain.algorithm.PriceBand
+import com.hosteldada.core.domain.algorithm.SnackFacetCounts
 import com.hosteldada.core.domain.model.*
+import com.hosteldada.feature.snackcart.domain.SearchMode
 
 /**
  * ============================================
@@ -20,8 +23,13 @@ data class SnackCartUiState(
     val snacks: List<Snack> = emptyList(),
     val filteredSnacks: List<Snack> = emptyList(),
     val selectedCategory: SnackCategory? = null,
+    val vegetarianOnly: Boolean = false,
+    val selectedPriceBands: Set<PriceBand> = emptySet(),
+    val facetCounts: SnackFacetCounts = SnackFacetCounts.EMPTY,
     val searchQuery: String = "",
+    val searchMode: SearchMode = SearchMode.TYPE_AHEAD,
     val searchResults: List<Snack> = emptyList(),
+    val searchSuggestions: List<String> = emptyList(),
     
     // Cart
     val cart: Cart = Cart(),
@@ -95,7 +103,12 @@ sealed interface SnackCartIntent {
     
     // Menu
     data class SelectCategory(val category: SnackCategory?) : SnackCartIntent
-    data class SearchSnacks(val query: String) : SnackCartIntent
+    data class SetVegetarianOnly(val enabled: Boolean) : SnackCartIntent
+    data class SelectPriceBands(val bands: Set<PriceBand>) : SnackCartIntent
+    data class SearchSnacks(
+        val query: String,
+        val mode: SearchMode = SearchMode.TYPE_AHEAD
+    ) : SnackCartIntent
     object ClearSearch : SnackCartIntent
     
     // Cart
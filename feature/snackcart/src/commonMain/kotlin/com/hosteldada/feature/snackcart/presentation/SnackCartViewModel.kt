@@ -2,12 +2,21 @@ package com.hosteldada.feature.snackcart.presentation
 
 import com.hosteldada.core.common.DispatcherProvider
 import com.hosteldada.core.common.result.Result
+import com.hosteldada.core.domain.algorithm.PriceBand
+import com.hosteldada.core.domain.algorithm.SnackCatalogDiff
+import com.hosteldada.core.domain.algorithm.SnackFacetSelection
 import com.hosteldada.core.domain.model.*
 import com.hosteldada.feature.snackcart.domain.*
 import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.NonCancellable
 import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.*
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
 
 /**
  * ============================================
@@ -19,8 +28,9 @@ class SnackCartViewModel(
     // Snacks
     private val getAllSnacks: GetAllSnacksUseCase,
     private val searchSnacks: SearchSnacksUseCase,
-    private val getSnacksByCategory: GetSnacksByCategoryUseCase,
+    private val filterSnacks: FilterSnacksUseCase,
     private val observeSnacks: ObserveSnacksUseCase,
+    private val getSnackRanking: GetSnackRankingUseCase,
     // Cart
     private val getCart: GetCartUseCase,
     private val addToCart: AddToCartUseCase,
@@ -45,8 +55,14 @@ class SnackCartViewModel(
     private var currentUserEmail: String = ""
     private var currentUserName: String = ""
     
+    // Catalog the search and facet indexes were last synced with
+    private var indexedCatalog: List<Snack> = emptyList()
+    private val catalogLock = Mutex()
+    private var persistJob: Job? = null
+    
     init {
         loadInitialData()
+        refreshRanking()
     }
     
     fun setCurrentUser(userId: String, email: String, name: String) {
@@ -63,7 +79,9 @@ class SnackCartViewModel(
             
             // Menu
             is SnackCartIntent.SelectCategory -> selectCategory(intent.category)
-            is SnackCartIntent.SearchSnacks -> searchSnacksAction(intent.query)
+            is SnackCartIntent.SetVegetarianOnly -> setVegetarianOnly(intent.enabled)
+            is SnackCartIntent.SelectPriceBands -> selectPriceBands(intent.bands)
+            is SnackCartIntent.SearchSnacks -> searchSnacksAction(intent.query, intent.mode)
             is SnackCartIntent.ClearSearch -> clearSearch()
             
             // Cart
@@ -98,13 +116,17 @@ class SnackCartViewModel(
         scope.launch {
             _uiState.update { it.copy(isLoading = true) }
             
+            // Search is usable from the persisted index while the catalog loads;
+            // decoding and checksumming stay off the main thread
+            withContext(dispatcher.default) { searchSnacks.restoreIndex() }
+            
             when (val result = getAllSnacks()) {
                 is Result.Success -> {
+                    syncCatalog(result.data)
                     _uiState.update { it.copy(
                         isLoading = false,
-                        snacks = result.data,
-                        filteredSnacks = result.data
-                    )}
+                        snacks = result.data
+                    ).withFacets() }
                 }
                 is Result.Error -> {
                     _uiState.update { it.copy(
@@ -127,25 +149,80 @@ class SnackCartViewModel(
         
         // Observe orders
         scope.launch {
+            var delivered = -1
             observeOrders(currentUserId).collect { orders ->
                 _uiState.update { it.copy(
                     orders = orders,
                     activeOrder = orders.firstOrNull { it.status != OrderStatus.DELIVERED && it.status != OrderStatus.CANCELLED }
                 )}
+                
+                // A delivery moves units sold, so popularity is reloaded
+                val deliveredNow = orders.count { it.status == OrderStatus.DELIVERED }
+                if (delivered >= 0 && deliveredNow > delivered) refreshRanking()
+                delivered = deliveredNow
             }
         }
         
         // Observe snacks
         scope.launch {
             observeSnacks().collect { snacks ->
-                _uiState.update { state ->
-                    val filtered = if (state.selectedCategory != null) {
-                        snacks.filter { it.category == state.selectedCategory }
-                    } else snacks
-                    
-                    state.copy(snacks = snacks, filteredSnacks = filtered)
+                syncCatalog(snacks)
+                _uiState.update { it.copy(snacks = snacks).withFacets() }
+            }
+        }
+    }
+    
+    /**
+     * Diff [snacks] against the last synced catalog once and hand that
+     * diff to every index, so a stock or availability flip patches them
+     * instead of rebuilding. Runs on the default dispatcher; callers only
+     * publish the result to the UI state on main. The initial load and
+     * catalog emissions may overlap, hence the lock.
+     */
+    private suspend fun syncCatalog(snacks: List<Snack>) = withContext(dispatcher.default) {
+        catalogLock.withLock {
+            val diff = SnackCatalogDiff.between(indexedCatalog, snacks)
+            if (diff.isEmpty) return@withLock
+            
+            searchSnacks.index(snacks, diff)
+            filterSnacks.index(snacks, diff)
+            indexedCatalog = snacks
+            schedulePersist()
+        }
+    }
+    
+    /**
+     * Rank search results, completions and the menu by units sold over
+     * delivered orders. Loaded at start and after each delivery; on
+     * failure the current ranking is kept.
+     */
+    private fun refreshRanking() {
+        scope.launch {
+            val result = getSnackRanking()
+            if (result !is Result.Success) return@launch
+            
+            withContext(dispatcher.default) {
+                catalogLock.withLock {
+                    searchSnacks.setRanking(result.data)
+                    filterSnacks.setRanking(result.data)
+                    schedulePersist()
                 }
             }
+            _uiState.update { it.withFacets() }
+            refreshSearch()
+        }
+    }
+    
+    /**
+     * Persist the search index once the catalog has been quiet for
+     * [PERSIST_DEBOUNCE_MS], on the io dispatcher. A burst of emissions
+     * writes once; a write that has started is never cancelled halfway.
+     */
+    private fun schedulePersist() {
+        persistJob?.cancel()
+        persistJob = scope.launch {
+            delay(PERSIST_DEBOUNCE_MS)
+            withContext(NonCancellable + dispatcher.io) { searchSnacks.persistIndex() }
         }
     }
     
@@ -157,49 +234,66 @@ class SnackCartViewModel(
         _uiState.update { it.copy(selectedTab = tab) }
     }
     
+    /**
+     * Category chips resolve from the facet index, no repository call
+     */
     private fun selectCategory(category: SnackCategory?) {
-        scope.launch {
-            _uiState.update { it.copy(selectedCategory = category, isLoading = true) }
-            
-            val result = if (category != null) {
-                getSnacksByCategory(category)
-            } else {
-                getAllSnacks()
-            }
-            
-            when (result) {
-                is Result.Success -> {
-                    _uiState.update { it.copy(
-                        isLoading = false,
-                        filteredSnacks = result.data
-                    )}
-                }
-                is Result.Error -> {
-                    _uiState.update { it.copy(
-                        isLoading = false,
-                        error = result.exception.message
-                    )}
-                }
-                is Result.Loading -> {}
-            }
-        }
+        _uiState.update { it.copy(selectedCategory = category).withFacets() }
+        refreshSearch()
+    }
+    
+    private fun setVegetarianOnly(enabled: Boolean) {
+        _uiState.update { it.copy(vegetarianOnly = enabled).withFacets() }
+        refreshSearch()
+    }
+    
+    private fun selectPriceBands(bands: Set<PriceBand>) {
+        _uiState.update { it.copy(selectedPriceBands = bands).withFacets() }
+        refreshSearch()
+    }
+    
+    private fun SnackCartUiState.facetSelection() = SnackFacetSelection(
+        category = selectedCategory,
+        vegetarianOnly = vegetarianOnly,
+        priceBands = selectedPriceBands
+    )
+    
+    // Menu list and chip counts by bitmap intersection
+    private fun SnackCartUiState.withFacets(): SnackCartUiState {
+        val selection = facetSelection()
+        return copy(
+            filteredSnacks = filterSnacks(selection),
+            facetCounts = filterSnacks.counts(selection)
+        )
+    }
+    
+    // Re-apply changed filters to the active search
+    private fun refreshSearch() {
+        val state = _uiState.value
+        if (state.searchQuery.isNotBlank()) searchSnacksAction(state.searchQuery, state.searchMode)
     }
     
     /**
-     * Search using Trie-based search for O(k) performance
+     * Search using Trie-based search for O(k) performance, or BM25 over
+     * descriptions too in [SearchMode.RELEVANCE] ("spicy", "protein")
      */
-    private fun searchSnacksAction(query: String) {
+    private fun searchSnacksAction(query: String, mode: SearchMode) {
         scope.launch {
-            _uiState.update { it.copy(searchQuery = query) }
+            _uiState.update { it.copy(searchQuery = query, searchMode = mode) }
             
             if (query.isBlank()) {
-                _uiState.update { it.copy(searchResults = emptyList()) }
+                _uiState.update { it.copy(searchResults = emptyList(), searchSuggestions = emptyList()) }
                 return@launch
             }
             
-            when (val result = searchSnacks(query)) {
+            when (val result = searchSnacks(query, mode)) {
                 is Result.Success -> {
-                    _uiState.update { it.copy(searchResults = result.data) }
+                    // Completions only extend type-ahead prefixes
+                    val suggestions = if (mode == SearchMode.TYPE_AHEAD) searchSnacks.suggestions(query) else emptyList()
+                    _uiState.update { it.copy(
+                        searchResults = filterSnacks(it.facetSelection(), within = result.data),
+                        searchSuggestions = suggestions
+                    )}
                 }
                 is Result.Error -> {
                     _uiState.update { it.copy(error = result.exception.message) }
@@ -210,7 +304,7 @@ class SnackCartViewModel(
     }
     
     private fun clearSearch() {
-        _uiState.update { it.copy(searchQuery = "", searchResults = emptyList()) }
+        _uiState.update { it.copy(searchQuery = "", searchResults = emptyList(), searchSuggestions = emptyList()) }
     }
     
     // ==========================================
@@ -218,9 +312,16 @@ class SnackCartViewModel(
     // ==========================================
     
     private fun addToCartAction(snack: Snack) {
+        // Only picks from the visible search results count towards autocomplete
+        val state = _uiState.value
+        val searchQuery = state.searchQuery.takeIf { query ->
+            query.isNotBlank() && state.searchResults.any { it.id == snack.id }
+        }
+        
         scope.launch {
             when (val result = addToCart(currentUserId, snack, 1)) {
                 is Result.Success -> {
+                    if (searchQuery != null) searchSnacks.recordSelection(searchQuery, snack)
                     _uiState.update { it.copy(successMessage = "${snack.name} added to cart") }
                 }
                 is Result.Error -> {
@@ -331,4 +432,9 @@ class SnackCartViewModel(
     private fun viewOrderDetails(order: SnackOrder) {
         _uiState.update { it.copy(activeOrder = order) }
     }
+    
+    private companion object {
+        // Catalog quiet time before the search index is written
+        const val PERSIST_DEBOUNCE_MS = 2_000L
+    }
 }
@@ -71,6 +71,9 @@ class FirestoreService {
     static let shared = FirestoreService()
     
     private let db = Firestore.firestore()
+    private let snackIndex = SnackSubstringIndex()
+    private let listenerLock = NSLock()
+    private var catalogListener: ListenerRegistration?
     
     // MARK: - User Profile
     func getUserProfile(userId: String) async throws -> [String: Any]? {
@@ -88,21 +91,42 @@ class FirestoreService {
             .whereField("available", isEqualTo: true)
             .getDocuments()
         
-        return snapshot.documents.map { doc in
+        let snacks = snapshot.documents.map { doc in
             var data = doc.data()
             data["id"] = doc.documentID
             return data
         }
+        snackIndex.rebuild(snacks)
+        return snacks
     }
     
     func searchSnacks(query: String) async throws -> [[String: Any]] {
-        // Firestore doesn't support full-text search natively
-        // Filter client-side or use Algolia/Elasticsearch
-        let allSnacks = try await getSnacks()
-        return allSnacks.filter { snack in
-            let name = snack["name"] as? String ?? ""
-            return name.localizedCaseInsensitiveContains(query)
+        // Firestore doesn't support full-text search natively, so the
+        // catalog is queried through a trigram index that a snapshot
+        // listener rebuilds whenever the available snacks change
+        listenForCatalogChanges()
+        if snackIndex.isEmpty {
+            _ = try await getSnacks()
         }
+        return snackIndex.search(query)
+    }
+    
+    private func listenForCatalogChanges() {
+        listenerLock.lock()
+        defer { listenerLock.unlock() }
+        guard catalogListener == nil else { return }
+        
+        catalogListener = db.collection("snacks")
+            .whereField("available", isEqualTo: true)
+            .addSnapshotListener { [weak self] snapshot, error in
+                guard let self = self, error == nil, let snapshot = snapshot else { return }
+                let snacks = snapshot.documents.map { doc in
+                    var data = doc.data()
+                    data["id"] = doc.documentID
+                    return data
+                }
+                self.snackIndex.rebuild(snacks)
+            }
     }
     
     // MARK: - Orders
@@ -209,3 +233,145 @@ class RealtimeDatabaseService {
         return Array(value.values)
     }
 }
+
+// MARK: - Snack Substring Index
+/**
+ * Trigram index over snack name, tags and category, mirroring the shared
+ * SnackTrigramIndex: queries of up to 3 chars read one posting list,
+ * longer ones intersect trigram postings smallest first and verify
+ * the survivors. Name matches come first.
+ *
+ * Folding follows the shared SnackTextNormalizer for Latin text (case,
+ * diacritics, apostrophes, punctuation to single spaces); Devanagari is
+ * not transliterated here.
+ */
+final class SnackSubstringIndex {
+    private static let gramSize = 3
+    
+    private let lock = NSLock()
+    private var snacks: [[String: Any]] = []
+    private var fields: [[String]] = []
+    private var grams: [String: [Int]] = [:]
+    
+    var isEmpty: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return snacks.isEmpty
+    }
+    
+    func rebuild(_ catalog: [[String: Any]]) {
+        var newFields: [[String]] = []
+        var newGrams: [String: [Int]] = [:]
+        
+        for (ordinal, snack) in catalog.enumerated() {
+            let folded = Self.fields(of: snack)
+            for field in folded {
+                let chars = Array(field)
+                for start in chars.indices {
+                    for length in 1...min(Self.gramSize, chars.count - start) {
+                        let gram = String(chars[start..<start + length])
+                        // Ordinals arrive in order, so a repeat is always the last one
+                        if newGrams[gram]?.last != ordinal {
+                            newGrams[gram, default: []].append(ordinal)
+                        }
+                    }
+                }
+            }
+            newFields.append(folded)
+        }
+        
+        lock.lock()
+        snacks = catalog
+        fields = newFields
+        grams = newGrams
+        lock.unlock()
+    }
+    
+    func search(_ query: String) -> [[String: Any]] {
+        let folded = Self.fold(query.trimmingCharacters(in: .whitespaces))
+        guard !folded.isEmpty else { return [] }
+        
+        lock.lock()
+        let snacks = self.snacks, fields = self.fields, grams = self.grams
+        lock.unlock()
+        
+        var nameHits: [[String: Any]] = []
+        var otherHits: [[String: Any]] = []
+        for ordinal in Self.candidates(folded, in: grams) {
+            if fields[ordinal][0].contains(folded) {
+                nameHits.append(snacks[ordinal])
+            } else if fields[ordinal].dropFirst().contains(where: { $0.contains(folded) }) {
+                otherHits.append(snacks[ordinal])
+            }
+        }
+        return nameHits + otherHits
+    }
+    
+    private static func candidates(_ query: String, in grams: [String: [Int]]) -> [Int] {
+        let chars = Array(query)
+        if chars.count <= gramSize {
+            return grams[query] ?? []
+        }
+        
+        var lists: [[Int]] = []
+        for start in 0...(chars.count - gramSize) {
+            guard let postings = grams[String(chars[start..<start + gramSize])] else { return [] }
+            lists.append(postings)
+        }
+        lists.sort { $0.count < $1.count }
+        return lists.dropFirst().reduce(lists[0]) { intersect($0, $1) }
+    }
+    
+    // Walk the shorter list, binary searching the longer one from the last hit
+    private static func intersect(_ a: [Int], _ b: [Int]) -> [Int] {
+        var result: [Int] = []
+        var low = 0
+        for value in a {
+            var lo = low, hi = b.count
+            while lo < hi {
+                let mid = (lo + hi) / 2
+                if b[mid] < value { lo = mid + 1 } else { hi = mid }
+            }
+            if lo == b.count { break }
+            if b[lo] == value {
+                result.append(value)
+                low = lo + 1
+            } else {
+                low = lo
+            }
+        }
+        return result
+    }
+    
+    // Folded, non-empty fields of a snack, name first
+    private static func fields(of snack: [String: Any]) -> [String] {
+        var fields = [fold(snack["name"] as? String ?? "")]
+        let tags = snack["tags"] as? [String] ?? []
+        fields += tags.map(fold).filter { !$0.isEmpty }
+        let category = fold(snack["category"] as? String ?? "")
+        if !category.isEmpty { fields.append(category) }
+        return fields
+    }
+    
+    private static func fold(_ text: String) -> String {
+        let stripped = text.folding(options: [.caseInsensitive, .diacriticInsensitive], locale: nil)
+        var out = ""
+        for scalar in stripped.unicodeScalars {
+            switch scalar {
+            case "'", "\u{2019}":
+                continue
+            case "0"..."9", "a"..."z":
+                out.unicodeScalars.append(scalar)
+            default:
+                // ASCII punctuation, underscores and whitespace become one space
+                if scalar.isASCII || scalar.properties.isWhitespace {
+                    if let last = out.unicodeScalars.last, last != " " { out.append(" ") }
+                } else {
+                    out.unicodeScalars.append(scalar)
+                }
+            }
+        }
+        if out.hasSuffix(" ") { out.removeLast() }
+        return out
+    }
+}
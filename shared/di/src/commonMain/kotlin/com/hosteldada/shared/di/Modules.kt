@@ -2,6 +2,7 @@ package com.hosteldada.shared.di
 
 import com.hosteldada.core.common.DispatcherProvider
 import com.hosteldada.core.common.DispatcherProviderImpl
+import com.hosteldada.core.common.telemetry.SearchTelemetry
 import org.koin.core.context.startKoin
 import org.koin.core.module.Module
 import org.koin.dsl.KoinAppDeclaration
@@ -21,6 +22,7 @@ import org.koin.dsl.module
 
 val coreModule = module {
     single<DispatcherProvider> { DispatcherProviderImpl() }
+    single { SearchTelemetry() }
 }
 
 // ==========================================
@@ -48,6 +50,7 @@ val repositoryModule = module {
     // Roomie
     // single<SurveyRepository> { SurveyRepositoryImpl(get()) }
     // single<CompatibilityRepository> { CompatibilityRepositoryImpl(get(), get()) }
+    // single<ScoringProfileRepository> { FirebaseScoringProfileRepositoryImpl(get(), get()) } (androidApp)
 }
 
 // ==========================================
@@ -63,15 +66,21 @@ val authUseCaseModule = module {
 
 val snackCartUseCaseModule = module {
     // factory { GetAllSnacksUseCase(get()) }
-    // factory { SearchSnacksUseCase(get()) }
+    // factory { SearchSnacksUseCase(get(), telemetry = get()) }
+    // factory { GetSearchTelemetryUseCase(get()) }
+    // factory { GetSnackStatsUseCase(get(), getSearchTelemetry = get()) }
+    // factory { GetSnackRankingUseCase(get()) }
     // factory { AddToCartUseCase(get()) }
     // factory { PlaceOrderUseCase(get(), get()) }
 }
 
 val roomieUseCaseModule = module {
-    // factory { SubmitSurveyUseCase(get()) }
-    // factory { GetTopMatchesUseCase(get()) }
-    // factory { GenerateAllCompatibilitiesUseCase(get()) }
+    // single { CompatibilityRowUpdater(get(), get(), get(), scoringProfileRepository = get()) }
+    // factory { SubmitSurveyUseCase(get(), get(), rowUpdater = get()) }
+    // factory { CalculateCompatibilityUseCase(get(), get(), scoringProfileRepository = get()) }
+    // factory { GetTopMatchesUseCase(get(), get(), scoringProfileRepository = get()) }
+    // factory { GenerateAllCompatibilitiesUseCase(get(), get(), get(), scoringProfileRepository = get()) }
+    // factory { ManageScoringProfileUseCase(get()) }
 }
 
 // ==========================================